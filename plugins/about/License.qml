@@ -6,31 +6,40 @@ import Ubuntu.SystemSettings.StorageAbout 1.0
 
 ItemPage {
     property string binary;
-    property string license: backendInfo.licenseInfo(binary);
 
     id: licensesPage
     title: binary
     flickable: scrollWidget
 
-    UbuntuStorageAboutPanel {
-        id: backendInfo
+    LicenseDocument {
+        id: licenseDocument
+        binary: licensesPage.binary
     }
 
-    Flickable {
+    Label {
+        anchors.fill: parent
+        anchors.margins: units.gu(2)
+        visible: !licenseDocument.valid
+        text: i18n.tr("Sorry, this license could not be displayed.")
+        wrapMode: Text.WordWrap
+    }
+
+    /* Only the paragraphs in view are instantiated, the document model
+       indexes the file as the list scrolls */
+    ListView {
         id: scrollWidget
         anchors.fill: parent
         anchors.margins: units.gu(2)
-        contentHeight: textId.height
+        visible: licenseDocument.valid
+        model: licenseDocument
         /* Set the direction to workaround https://bugreports.qt-project.org/browse/QTBUG-31905
            otherwise the UI might end up in a situation where scrolling doesn't work */
         flickableDirection: Flickable.VerticalFlick
 
-        Label {
-            id: textId
-            text: license ? license : i18n.tr("Sorry, this license could not be displayed.")
+        delegate: Label {
+            text: model.text
             width: scrollWidget.width
             wrapMode: Text.WordWrap
         }
     }
 }
-
@@ -174,6 +174,24 @@ ItemPage {
                     ready: backendInfo.ready
                 }
             }
+
+            ListItem.Header {
+                text: i18n.tr("Installed apps")
+                visible: appStorage.count > 0
+            }
+
+            /* Rows are streamed in, largest first, as each app is measured */
+            Repeater {
+                model: AppStorageModel {
+                    id: appStorage
+                }
+
+                ListItem.SingleValue {
+                    objectName: "appStorageItem_" + model.packageName
+                    text: model.displayName
+                    value: Utilities.formatSize(model.totalSize)
+                }
+            }
         }
     }
         }
@@ -0,0 +1,394 @@
+/*
+ * Copyright (C) 2016 Canonical Ltd
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+*/
+
+#include "appstoragemodel.h"
+
+#include <glib.h>
+
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSet>
+#include <QStandardPaths>
+#include <QtConcurrent>
+
+namespace {
+    const QString CLICK_ROOT = "/opt/click.ubuntu.com";
+    /* Directories measured at the same time; each measurement walks a
+       whole tree, so more would only compete for the same disk */
+    const int MAX_PARALLEL_JOBS = 4;
+}
+
+struct AppMeasureData {
+    AppStorageModel *model;
+    QString name;
+    int part;
+};
+
+static void app_measure_finished(GObject *source_object,
+                                 GAsyncResult *result,
+                                 gpointer user_data)
+{
+    GError *err = nullptr;
+    GFile *file = G_FILE (source_object);
+    guint64 size = 0;
+
+    auto data = static_cast<AppMeasureData *>(user_data);
+
+    g_file_measure_disk_usage_finish (
+                file,
+                result,
+                &size,
+                nullptr, /* num_dirs */
+                nullptr, /* num_files */
+                &err);
+
+    if (err != nullptr) {
+        if (g_error_matches (err, G_IO_ERROR, G_IO_ERROR_CANCELLED)) {
+            delete data;
+            g_clear_object (&file);
+            g_error_free (err);
+            return;
+        }
+        /* Applications without data or cache are expected */
+        if (!g_error_matches (err, G_IO_ERROR, G_IO_ERROR_NOT_FOUND)) {
+            gchar *path = g_file_get_path (file);
+            qWarning() << "Measuring of" << path << "failed:" << err->message;
+            g_free (path);
+        }
+        g_error_free (err);
+        size = 0;
+    }
+
+    data->model->partMeasured(data->name, data->part, size);
+
+    delete data;
+    g_clear_object (&file);
+}
+
+/* Runs on a worker thread */
+static QList<AppStorageModel::Package> listPackages()
+{
+    QList<AppStorageModel::Package> packages;
+    QDir root(CLICK_ROOT);
+
+    Q_FOREACH(const QString &name,
+              root.entryList(QDir::Dirs | QDir::NoDotAndDotDot)) {
+        QDir current(root.filePath(name + "/current"));
+        if (!current.exists())
+            continue;
+
+        AppStorageModel::Package package;
+        package.name = name;
+        package.title = name;
+        package.installPath = current.canonicalPath();
+
+        QFile manifest(current.filePath(".click/info/" + name + ".manifest"));
+        if (manifest.open(QIODevice::ReadOnly)) {
+            QJsonObject json = QJsonDocument::fromJson(manifest.readAll()).object();
+            package.title = json.value("title").toString(name);
+            package.version = json.value("version").toString();
+        }
+
+        packages.append(package);
+    }
+
+    return packages;
+}
+
+AppStorageModel::AppStorageModel(QObject *parent) :
+    QAbstractListModel(parent),
+    m_running(0),
+    m_cancellable(nullptr),
+    m_cache(QStandardPaths::writableLocation(QStandardPaths::CacheLocation)
+            + "/app-storage.ini", QSettings::IniFormat)
+{
+    connect(&m_listWatcher, SIGNAL(finished()),
+            this, SLOT(packagesListed()));
+    refresh();
+}
+
+AppStorageModel::~AppStorageModel()
+{
+    if (m_cancellable) {
+        g_cancellable_cancel(m_cancellable);
+        g_clear_object(&m_cancellable);
+    }
+}
+
+bool AppStorageModel::measuring() const
+{
+    return m_running > 0 || !m_jobs.isEmpty() || m_listWatcher.isRunning();
+}
+
+void AppStorageModel::refresh()
+{
+    if (m_cancellable) {
+        g_cancellable_cancel(m_cancellable);
+        g_clear_object(&m_cancellable);
+    }
+    m_cancellable = g_cancellable_new();
+
+    m_jobs.clear();
+    m_pending.clear();
+    m_running = 0;
+
+    m_listWatcher.setFuture(QtConcurrent::run(listPackages));
+    Q_EMIT measuringChanged();
+}
+
+void AppStorageModel::packagesListed()
+{
+    QList<Package> packages = m_listWatcher.result();
+    QSet<QString> installed;
+
+    Q_FOREACH(const Package &package, packages)
+        installed.insert(package.name);
+
+    for (int i = m_entries.size() - 1; i >= 0; i--) {
+        if (installed.contains(m_entries[i].package.name))
+            continue;
+        beginRemoveRows(QModelIndex(), i, i);
+        m_entries.removeAt(i);
+        endRemoveRows();
+        Q_EMIT countChanged();
+    }
+
+    loadCache(packages);
+
+    const QString dataDir = QString::fromUtf8(g_get_user_data_dir());
+    const QString cacheDir = QString::fromUtf8(g_get_user_cache_dir());
+
+    Q_FOREACH(const Package &package, packages) {
+        Pending pending;
+        pending.package = package;
+        pending.remaining = PartCount;
+        for (int part = 0; part < PartCount; part++)
+            pending.sizes[part] = 0;
+        m_pending.insert(package.name, pending);
+
+        Job job;
+        job.name = package.name;
+        job.part = InstalledPart;
+        job.path = package.installPath;
+        m_jobs.enqueue(job);
+        job.part = DataPart;
+        job.path = dataDir + "/" + package.name;
+        m_jobs.enqueue(job);
+        job.part = CachePart;
+        job.path = cacheDir + "/" + package.name;
+        m_jobs.enqueue(job);
+    }
+
+    startJobs();
+    Q_EMIT measuringChanged();
+}
+
+void AppStorageModel::startJobs()
+{
+    while (m_running < MAX_PARALLEL_JOBS && !m_jobs.isEmpty()) {
+        Job job = m_jobs.dequeue();
+
+        auto data = new AppMeasureData;
+        data->model = this;
+        data->name = job.name;
+        data->part = job.part;
+
+        GFile *file = g_file_new_for_path(job.path.toUtf8().constData());
+        g_file_measure_disk_usage_async (
+                    file,
+                    G_FILE_MEASURE_NONE,
+                    G_PRIORITY_LOW,
+                    m_cancellable,
+                    nullptr, /* progress_callback */
+                    nullptr, /* progress_data */
+                    app_measure_finished,
+                    data);
+        m_running++;
+    }
+}
+
+void AppStorageModel::partMeasured(const QString &name, int part,
+                                   quint64 size)
+{
+    m_running--;
+
+    auto it = m_pending.find(name);
+    if (it != m_pending.end()) {
+        it->sizes[part] = size;
+        if (--it->remaining == 0) {
+            Entry entry;
+            entry.package = it->package;
+            for (int i = 0; i < PartCount; i++)
+                entry.sizes[i] = it->sizes[i];
+            entry.measured = true;
+            m_pending.erase(it);
+
+            setEntry(entry);
+            storeCache(entry);
+        }
+    }
+
+    startJobs();
+
+    if (!measuring())
+        Q_EMIT measuringChanged();
+}
+
+void AppStorageModel::loadCache(const QList<Package> &packages)
+{
+    Q_FOREACH(const Package &package, packages) {
+        bool known = false;
+        Q_FOREACH(const Entry &entry, m_entries) {
+            if (entry.package.name == package.name) {
+                known = true;
+                break;
+            }
+        }
+        if (known)
+            continue;
+
+        m_cache.beginGroup(package.name);
+        if (m_cache.value("version").toString() == package.version) {
+            Entry entry;
+            entry.package = package;
+            entry.sizes[InstalledPart] = m_cache.value("installed").toULongLong();
+            entry.sizes[DataPart] = m_cache.value("data").toULongLong();
+            entry.sizes[CachePart] = m_cache.value("cache").toULongLong();
+            entry.measured = false;
+            m_cache.endGroup();
+            setEntry(entry);
+        } else {
+            m_cache.endGroup();
+        }
+    }
+}
+
+void AppStorageModel::storeCache(const Entry &entry)
+{
+    m_cache.beginGroup(entry.package.name);
+    m_cache.setValue("version", entry.package.version);
+    m_cache.setValue("installed", entry.sizes[InstalledPart]);
+    m_cache.setValue("data", entry.sizes[DataPart]);
+    m_cache.setValue("cache", entry.sizes[CachePart]);
+    m_cache.endGroup();
+}
+
+/* First row, ignoring row skip, whose total is smaller than total; rows
+   of equal size keep their order. */
+int AppStorageModel::insertionRow(quint64 total, int skip) const
+{
+    int low = 0;
+    int high = m_entries.size() - (skip >= 0 ? 1 : 0);
+
+    while (low < high) {
+        int mid = (low + high) / 2;
+        int i = (skip >= 0 && mid >= skip) ? mid + 1 : mid;
+        if (m_entries[i].total() >= total)
+            low = mid + 1;
+        else
+            high = mid;
+    }
+
+    return low;
+}
+
+void AppStorageModel::setEntry(const Entry &entry)
+{
+    int row = -1;
+    for (int i = 0; i < m_entries.size(); i++) {
+        if (m_entries[i].package.name == entry.package.name) {
+            row = i;
+            break;
+        }
+    }
+
+    if (row < 0) {
+        row = insertionRow(entry.total());
+        beginInsertRows(QModelIndex(), row, row);
+        m_entries.insert(row, entry);
+        endInsertRows();
+        Q_EMIT countChanged();
+        return;
+    }
+
+    int target = insertionRow(entry.total(), row);
+    m_entries[row] = entry;
+    if (target != row) {
+        beginMoveRows(QModelIndex(), row, row, QModelIndex(),
+                      target > row ? target + 1 : target);
+        m_entries.move(row, target);
+        endMoveRows();
+    }
+
+    QModelIndex changed = index(target, 0);
+    Q_EMIT dataChanged(changed, changed);
+}
+
+int AppStorageModel::rowCount(const QModelIndex &parent) const
+{
+    if (parent.isValid())
+        return 0;
+    return m_entries.size();
+}
+
+QVariant AppStorageModel::data(const QModelIndex &index, int role) const
+{
+    if (index.row() >= m_entries.size() || index.row() < 0)
+        return QVariant();
+
+    const Entry &entry = m_entries[index.row()];
+
+    switch (role) {
+    case PackageNameRole:
+        return entry.package.name;
+    case Qt::DisplayRole:
+    case DisplayNameRole:
+        return entry.package.title;
+    case VersionRole:
+        return entry.package.version;
+    case InstalledSizeRole:
+        return entry.sizes[InstalledPart];
+    case DataSizeRole:
+        return entry.sizes[DataPart];
+    case CacheSizeRole:
+        return entry.sizes[CachePart];
+    case TotalSizeRole:
+        return entry.total();
+    case MeasuredRole:
+        return entry.measured;
+    default:
+        return QVariant();
+    }
+}
+
+QHash<int, QByteArray> AppStorageModel::roleNames() const
+{
+    QHash<int, QByteArray> roleNames;
+    roleNames[PackageNameRole] = "packageName";
+    roleNames[DisplayNameRole] = "displayName";
+    roleNames[VersionRole] = "version";
+    roleNames[InstalledSizeRole] = "installedSize";
+    roleNames[DataSizeRole] = "dataSize";
+    roleNames[CacheSizeRole] = "cacheSize";
+    roleNames[TotalSizeRole] = "totalSize";
+    roleNames[MeasuredRole] = "measured";
+
+    return roleNames;
+}
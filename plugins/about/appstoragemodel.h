@@ -0,0 +1,131 @@
+/*
+ * Copyright (C) 2016 Canonical Ltd
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+*/
+
+#ifndef APPSTORAGEMODEL_H
+#define APPSTORAGEMODEL_H
+
+#include <gio/gio.h>
+
+#include <QAbstractListModel>
+#include <QFutureWatcher>
+#include <QHash>
+#include <QList>
+#include <QQueue>
+#include <QSettings>
+
+/* Disk usage of each installed click application: its install directory
+ * plus its data and cache directories.  The directories are measured by a
+ * small pool of parallel GIO jobs; rows are inserted (sorted by total size,
+ * largest first) as each application completes, and results are written to
+ * a cache so the list can be shown straight away next time. */
+class AppStorageModel : public QAbstractListModel
+{
+    Q_OBJECT
+
+    Q_PROPERTY(int count
+               READ rowCount
+               NOTIFY countChanged)
+
+    Q_PROPERTY(bool measuring
+               READ measuring
+               NOTIFY measuringChanged)
+
+public:
+    enum Roles {
+        PackageNameRole = Qt::UserRole + 1,
+        DisplayNameRole,
+        VersionRole,
+        InstalledSizeRole,
+        DataSizeRole,
+        CacheSizeRole,
+        TotalSizeRole,
+        MeasuredRole
+    };
+
+    enum Part {
+        InstalledPart = 0,
+        DataPart,
+        CachePart,
+        PartCount
+    };
+
+    struct Package {
+        QString name;
+        QString title;
+        QString version;
+        QString installPath;
+    };
+
+    explicit AppStorageModel(QObject *parent = 0);
+    ~AppStorageModel();
+
+    bool measuring() const;
+    Q_INVOKABLE void refresh();
+
+    // implemented virtual methods from QAbstractListModel
+    int rowCount(const QModelIndex &parent = QModelIndex()) const;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const;
+    QHash<int, QByteArray> roleNames() const;
+
+    void partMeasured(const QString &name, int part, quint64 size);
+
+Q_SIGNALS:
+    void countChanged();
+    void measuringChanged();
+
+private Q_SLOTS:
+    void packagesListed();
+
+private:
+    struct Entry {
+        Package package;
+        quint64 sizes[PartCount];
+        bool measured;
+
+        quint64 total() const {
+            return sizes[InstalledPart] + sizes[DataPart] + sizes[CachePart];
+        }
+    };
+
+    struct Job {
+        QString name;
+        int part;
+        QString path;
+    };
+
+    struct Pending {
+        Package package;
+        quint64 sizes[PartCount];
+        int remaining;
+    };
+
+    void loadCache(const QList<Package> &packages);
+    void storeCache(const Entry &entry);
+    void setEntry(const Entry &entry);
+    int insertionRow(quint64 total, int skip = -1) const;
+    void startJobs();
+
+    QList<Entry> m_entries;
+    QHash<QString, Pending> m_pending;
+    QQueue<Job> m_jobs;
+    int m_running;
+    GCancellable *m_cancellable;
+    QSettings m_cache;
+    QFutureWatcher<QList<Package> > m_listWatcher;
+};
+
+#endif // APPSTORAGEMODEL_H
@@ -0,0 +1,210 @@
+/*
+ * Copyright (C) 2016 Canonical Ltd
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+*/
+
+#include "deviceinfosnapshot.h"
+
+#include <QDBusConnection>
+#include <QDBusMessage>
+#include <QDBusPendingReply>
+#include <QDebug>
+#include <QFile>
+#include <QQmlEngine>
+#include <QtConcurrent>
+#include <hybris/properties/properties.h>
+
+namespace {
+    const QString PROPERTY_SERVICE_PATH = "/com/canonical/PropertyService";
+    const QString PROPERTY_SERVICE_OBJ = "com.canonical.PropertyService";
+}
+
+static QString readProperty(const char *key)
+{
+    char buffer[PROP_VALUE_MAX];
+    property_get(key, buffer, "");
+    return QString(buffer);
+}
+
+/* Runs on a worker thread */
+static DeviceInfoSnapshot::Fields readFields()
+{
+    DeviceInfoSnapshot::Fields fields;
+
+    fields.serialNumber = readProperty("ro.serialno");
+    fields.vendorString = QString("%1 %2")
+        .arg(readProperty("ro.product.manufacturer"))
+        .arg(readProperty("ro.product.model"));
+    fields.deviceBuildDisplayID = readProperty("ro.build.display.id");
+
+    QFile file(qgetenv("SNAP").append("/etc/media-info"));
+    if (file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        fields.ubuntuBuildID = QString(file.readAll());
+        file.close();
+    }
+
+    return fields;
+}
+
+DeviceInfoSnapshot *DeviceInfoSnapshot::instance()
+{
+    static DeviceInfoSnapshot *snapshot = nullptr;
+
+    if (!snapshot) {
+        snapshot = new DeviceInfoSnapshot();
+        QQmlEngine::setObjectOwnership(snapshot, QQmlEngine::CppOwnership);
+        snapshot->refresh();
+    }
+
+    return snapshot;
+}
+
+DeviceInfoSnapshot::DeviceInfoSnapshot(QObject *parent) :
+    QObject(parent),
+    m_developerModeCapable(false),
+    m_developerMode(false),
+    m_pending(0)
+{
+    connect(&m_fieldsWatcher, SIGNAL(finished()),
+            this, SLOT(fieldsFinished()));
+}
+
+DeviceInfoSnapshot::~DeviceInfoSnapshot()
+{
+    m_fieldsWatcher.waitForFinished();
+}
+
+void DeviceInfoSnapshot::refresh()
+{
+    m_pending = 2;
+
+    m_fieldsWatcher.setFuture(QtConcurrent::run(readFields));
+
+    /* Plain message rather than a QDBusInterface, which would introspect
+       the service synchronously */
+    QDBusMessage msg = QDBusMessage::createMethodCall(PROPERTY_SERVICE_OBJ,
+                                                      PROPERTY_SERVICE_PATH,
+                                                      PROPERTY_SERVICE_OBJ,
+                                                      "GetProperty");
+    msg << QString("adb");
+    QDBusPendingCall call = QDBusConnection::systemBus().asyncCall(msg);
+    auto watcher = new QDBusPendingCallWatcher(call, this);
+    connect(watcher, SIGNAL(finished(QDBusPendingCallWatcher*)),
+            this, SLOT(developerModeFinished(QDBusPendingCallWatcher*)));
+}
+
+void DeviceInfoSnapshot::fieldsFinished()
+{
+    m_fields = m_fieldsWatcher.result();
+    partDone();
+}
+
+void DeviceInfoSnapshot::developerModeFinished(QDBusPendingCallWatcher *call)
+{
+    QDBusPendingReply<bool> reply = *call;
+
+    if (reply.isError()) {
+        qWarning("devMode: no reply from dbus property service");
+        m_developerModeCapable = false;
+        m_developerMode = false;
+    } else {
+        m_developerModeCapable = true;
+        m_developerMode = reply.value();
+    }
+
+    call->deleteLater();
+    partDone();
+}
+
+void DeviceInfoSnapshot::partDone()
+{
+    if (--m_pending > 0)
+        return;
+
+    Q_EMIT ready();
+    Q_EMIT developerModeChanged();
+}
+
+bool DeviceInfoSnapshot::loaded() const
+{
+    return m_pending == 0;
+}
+
+QString DeviceInfoSnapshot::serialNumber() const
+{
+    return m_fields.serialNumber;
+}
+
+QString DeviceInfoSnapshot::vendorString() const
+{
+    return m_fields.vendorString;
+}
+
+QString DeviceInfoSnapshot::deviceBuildDisplayID() const
+{
+    return m_fields.deviceBuildDisplayID;
+}
+
+QString DeviceInfoSnapshot::ubuntuBuildID() const
+{
+    return m_fields.ubuntuBuildID;
+}
+
+bool DeviceInfoSnapshot::developerModeCapable() const
+{
+    return m_developerModeCapable;
+}
+
+bool DeviceInfoSnapshot::developerMode() const
+{
+    return m_developerMode;
+}
+
+void DeviceInfoSnapshot::setDeveloperMode(bool mode)
+{
+    QDBusMessage msg = QDBusMessage::createMethodCall(PROPERTY_SERVICE_OBJ,
+                                                      PROPERTY_SERVICE_PATH,
+                                                      PROPERTY_SERVICE_OBJ,
+                                                      "SetProperty");
+    msg << QString("adb") << mode;
+    QDBusPendingCall call = QDBusConnection::systemBus().asyncCall(msg);
+    auto watcher = new QDBusPendingCallWatcher(call, this);
+    watcher->setProperty("mode", mode);
+    watcher->setProperty("previousMode", m_developerMode);
+    connect(watcher, SIGNAL(finished(QDBusPendingCallWatcher*)),
+            this, SLOT(developerModeSet(QDBusPendingCallWatcher*)));
+
+    if (m_developerMode != mode) {
+        m_developerMode = mode;
+        Q_EMIT developerModeChanged();
+    }
+}
+
+void DeviceInfoSnapshot::developerModeSet(QDBusPendingCallWatcher *call)
+{
+    QDBusPendingReply<> reply = *call;
+    call->deleteLater();
+
+    if (!reply.isError())
+        return;
+
+    qWarning() << "devMode: could not be set:" << reply.error().message();
+
+    // Unless a later call has changed it again, show what is in effect.
+    if (m_developerMode == call->property("mode").toBool()) {
+        m_developerMode = call->property("previousMode").toBool();
+        Q_EMIT developerModeChanged();
+    }
+}
@@ -0,0 +1,104 @@
+/*
+ * Copyright (C) 2016 Canonical Ltd
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+*/
+
+#ifndef DEVICEINFOSNAPSHOT_H
+#define DEVICEINFOSNAPSHOT_H
+
+#include <QDBusPendingCallWatcher>
+#include <QFutureWatcher>
+#include <QObject>
+#include <QString>
+
+/* Device identification shown on the About pages.  The Android properties
+ * and media-info file are read on a worker thread while the property
+ * service is queried asynchronously; ready() is emitted once everything
+ * is in.  One snapshot is shared by all pages for the whole session. */
+class DeviceInfoSnapshot : public QObject
+{
+    Q_OBJECT
+
+    Q_PROPERTY(bool loaded
+               READ loaded
+               NOTIFY ready)
+
+    Q_PROPERTY(QString serialNumber
+               READ serialNumber
+               NOTIFY ready)
+
+    Q_PROPERTY(QString vendorString
+               READ vendorString
+               NOTIFY ready)
+
+    Q_PROPERTY(QString deviceBuildDisplayID
+               READ deviceBuildDisplayID
+               NOTIFY ready)
+
+    Q_PROPERTY(QString ubuntuBuildID
+               READ ubuntuBuildID
+               NOTIFY ready)
+
+    Q_PROPERTY(bool developerModeCapable
+               READ developerModeCapable
+               NOTIFY ready)
+
+    Q_PROPERTY(bool developerMode
+               READ developerMode
+               WRITE setDeveloperMode
+               NOTIFY developerModeChanged)
+
+public:
+    struct Fields {
+        QString serialNumber;
+        QString vendorString;
+        QString deviceBuildDisplayID;
+        QString ubuntuBuildID;
+    };
+
+    static DeviceInfoSnapshot *instance();
+    ~DeviceInfoSnapshot();
+
+    bool loaded() const;
+    QString serialNumber() const;
+    QString vendorString() const;
+    QString deviceBuildDisplayID() const;
+    QString ubuntuBuildID() const;
+    bool developerModeCapable() const;
+    bool developerMode() const;
+    void setDeveloperMode(bool mode);
+
+Q_SIGNALS:
+    void ready();
+    void developerModeChanged();
+
+private Q_SLOTS:
+    void fieldsFinished();
+    void developerModeFinished(QDBusPendingCallWatcher *call);
+    void developerModeSet(QDBusPendingCallWatcher *call);
+
+private:
+    explicit DeviceInfoSnapshot(QObject *parent = 0);
+    void refresh();
+    void partDone();
+
+    Fields m_fields;
+    bool m_developerModeCapable;
+    bool m_developerMode;
+    int m_pending;
+    QFutureWatcher<Fields> m_fieldsWatcher;
+};
+
+#endif // DEVICEINFOSNAPSHOT_H
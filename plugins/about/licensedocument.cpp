@@ -0,0 +1,344 @@
+/*
+ * Copyright (C) 2016 Canonical Ltd
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+*/
+
+#include "licensedocument.h"
+
+#include <QDebug>
+#include <QFile>
+#include <QStandardPaths>
+#include <QtConcurrent>
+
+namespace {
+    /* Number of paragraphs indexed per fetchMore() */
+    const int CHUNKS_PER_FETCH = 32;
+    /* Paragraphs longer than this are split on a line boundary, so that a
+       single row never gets too expensive to lay out */
+    const qint64 MAX_CHUNK_SIZE = 4096;
+}
+
+struct LicenseDocument::Mapping {
+    QFile file;
+    QByteArray buffer;
+    const char *data;
+    qint64 size;
+
+    Mapping(const QString &path):
+        file(path),
+        data(nullptr),
+        size(0) {}
+
+    ~Mapping() {
+        if (file.isOpen())
+            file.close();
+    }
+};
+
+static inline char foldAscii(char c)
+{
+    return (c >= 'A' && c <= 'Z') ? c + ('a' - 'A') : c;
+}
+
+/* Runs on a worker thread; the mapping is kept alive by the shared pointer
+   even if the document switches to another file meanwhile. */
+static QList<qint64> findMatches(QSharedPointer<LicenseDocument::Mapping> mapping,
+                                 QByteArray needle,
+                                 QSharedPointer<QAtomicInt> cancelled)
+{
+    QList<qint64> offsets;
+    const qint64 len = needle.size();
+
+    if (len == 0 || len > mapping->size)
+        return offsets;
+
+    for (int i = 0; i < len; i++)
+        needle[i] = foldAscii(needle[i]);
+
+    const char *data = mapping->data;
+    const char first = needle[0];
+    const qint64 last = mapping->size - len;
+
+    for (qint64 i = 0; i <= last; i++) {
+        if ((i & 0xffff) == 0 && cancelled->load())
+            return QList<qint64>();
+        if (foldAscii(data[i]) != first)
+            continue;
+        qint64 j = 1;
+        while (j < len && foldAscii(data[i + j]) == needle[j])
+            j++;
+        if (j == len) {
+            offsets.append(i);
+            i += len - 1;
+        }
+    }
+
+    return offsets;
+}
+
+LicenseDocument::LicenseDocument(QObject *parent) :
+    QAbstractListModel(parent),
+    m_indexed(0)
+{
+    connect(&m_findWatcher, SIGNAL(finished()),
+            this, SLOT(onFindFinished()));
+}
+
+LicenseDocument::~LicenseDocument()
+{
+    if (m_findCancelled)
+        m_findCancelled->store(1);
+}
+
+QString LicenseDocument::binary() const
+{
+    return m_binary;
+}
+
+void LicenseDocument::setBinary(const QString &binary)
+{
+    if (binary == m_binary)
+        return;
+
+    m_binary = binary;
+    open();
+    Q_EMIT binaryChanged();
+}
+
+bool LicenseDocument::valid() const
+{
+    return !m_mapping.isNull();
+}
+
+bool LicenseDocument::searching() const
+{
+    return m_findWatcher.isRunning();
+}
+
+void LicenseDocument::open()
+{
+    bool wasValid = valid();
+
+    cancelFind();
+
+    beginResetModel();
+    m_chunks.clear();
+    m_indexed = 0;
+    m_mapping.clear();
+
+    QString copyrightFile = QStandardPaths::locate(
+        QStandardPaths::GenericDataLocation,
+        "doc/" + m_binary + "/copyright",
+        QStandardPaths::LocateFile
+    );
+
+    if (!m_binary.isEmpty() && !copyrightFile.isEmpty()) {
+        QSharedPointer<Mapping> mapping(new Mapping(copyrightFile));
+        if (mapping->file.open(QIODevice::ReadOnly)) {
+            mapping->size = mapping->file.size();
+            uchar *mapped = mapping->size > 0 ?
+                mapping->file.map(0, mapping->size) : nullptr;
+            if (mapped) {
+                mapping->data = reinterpret_cast<const char *>(mapped);
+            } else {
+                /* Not mappable (e.g. a pipe or an empty file), fall back
+                   to reading it */
+                mapping->buffer = mapping->file.readAll();
+                mapping->size = mapping->buffer.size();
+                mapping->data = mapping->buffer.constData();
+            }
+            m_mapping = mapping;
+        } else {
+            qWarning() << "Could not open" << copyrightFile
+                       << mapping->file.errorString();
+        }
+    }
+
+    endResetModel();
+
+    if (wasValid != valid())
+        Q_EMIT validChanged();
+}
+
+/* Indexes up to count more paragraphs (or, with untilOffset, as many as
+   needed to cover that offset) and inserts them as rows. */
+int LicenseDocument::indexChunks(int count, qint64 untilOffset)
+{
+    if (m_mapping.isNull() || m_indexed >= m_mapping->size)
+        return 0;
+
+    const QByteArray raw = QByteArray::fromRawData(m_mapping->data,
+                                                   m_mapping->size);
+    const qint64 size = m_mapping->size;
+    QVector<Chunk> added;
+    qint64 start = m_indexed;
+
+    while (start < size &&
+           (added.size() < count || (untilOffset >= 0 && start <= untilOffset))) {
+        qint64 end = raw.indexOf("\n\n", start);
+        end = (end < 0) ? size : end + 2;
+        while (end < size && raw.at(end) == '\n')
+            end++;
+
+        if (end - start > MAX_CHUNK_SIZE) {
+            qint64 cut = raw.lastIndexOf('\n', start + MAX_CHUNK_SIZE);
+            if (cut > start) {
+                end = cut + 1;
+            } else {
+                /* One very long line, don't split a UTF-8 sequence */
+                end = start + MAX_CHUNK_SIZE;
+                while (end > start + 1 && (raw.at(end) & 0xC0) == 0x80)
+                    end--;
+            }
+        }
+
+        Chunk chunk;
+        chunk.offset = start;
+        chunk.length = end - start;
+        added.append(chunk);
+        start = end;
+    }
+
+    if (added.isEmpty())
+        return 0;
+
+    beginInsertRows(QModelIndex(), m_chunks.size(),
+                    m_chunks.size() + added.size() - 1);
+    m_chunks += added;
+    m_indexed = start;
+    endInsertRows();
+
+    return added.size();
+}
+
+int LicenseDocument::rowForOffset(qint64 offset)
+{
+    if (m_mapping.isNull() || offset < 0 || offset >= m_mapping->size)
+        return -1;
+
+    if (offset >= m_indexed)
+        indexChunks(0, offset);
+
+    int low = 0;
+    int high = m_chunks.size() - 1;
+    while (low <= high) {
+        int mid = (low + high) / 2;
+        const Chunk &chunk = m_chunks[mid];
+        if (offset < chunk.offset)
+            high = mid - 1;
+        else if (offset >= chunk.offset + chunk.length)
+            low = mid + 1;
+        else
+            return mid;
+    }
+    return -1;
+}
+
+void LicenseDocument::find(const QString &text)
+{
+    cancelFind();
+
+    m_findText = text;
+    if (m_mapping.isNull() || text.isEmpty()) {
+        Q_EMIT findFinished(text, QVariantList());
+        return;
+    }
+
+    m_findCancelled = QSharedPointer<QAtomicInt>(new QAtomicInt(0));
+    m_findWatcher.setFuture(QtConcurrent::run(findMatches, m_mapping,
+                                              text.toUtf8(),
+                                              m_findCancelled));
+    Q_EMIT searchingChanged();
+}
+
+void LicenseDocument::cancelFind()
+{
+    if (!m_findCancelled)
+        return;
+
+    /* Drop the pending result, a stale search must not be reported;
+       onFindFinished() ignores anything arriving without a token */
+    m_findCancelled->store(1);
+    m_findCancelled.clear();
+    m_findWatcher.setFuture(QFuture<QList<qint64> >());
+    Q_EMIT searchingChanged();
+}
+
+void LicenseDocument::onFindFinished()
+{
+    if (!m_findCancelled || !m_findWatcher.future().isResultReadyAt(0))
+        return;
+    m_findCancelled.clear();
+
+    QVariantList offsets;
+    Q_FOREACH(qint64 offset, m_findWatcher.result())
+        offsets.append(offset);
+
+    Q_EMIT searchingChanged();
+    Q_EMIT findFinished(m_findText, offsets);
+}
+
+int LicenseDocument::rowCount(const QModelIndex &parent) const
+{
+    if (parent.isValid())
+        return 0;
+    return m_chunks.size();
+}
+
+QVariant LicenseDocument::data(const QModelIndex &index, int role) const
+{
+    if (index.row() >= m_chunks.size() || index.row() < 0)
+        return QVariant();
+
+    const Chunk &chunk = m_chunks[index.row()];
+
+    switch (role) {
+    case Qt::DisplayRole:
+    case TextRole: {
+        /* Keep the blank line ending a paragraph, it spaces the rows */
+        qint64 length = chunk.length;
+        if (length > 0 && m_mapping->data[chunk.offset + length - 1] == '\n')
+            length--;
+        return QString::fromUtf8(m_mapping->data + chunk.offset, length);
+    }
+    case OffsetRole:
+        return chunk.offset;
+    default:
+        return QVariant();
+    }
+}
+
+QHash<int, QByteArray> LicenseDocument::roleNames() const
+{
+    QHash<int, QByteArray> roleNames;
+    roleNames[TextRole] = "text";
+    roleNames[OffsetRole] = "offset";
+
+    return roleNames;
+}
+
+bool LicenseDocument::canFetchMore(const QModelIndex &parent) const
+{
+    if (parent.isValid() || m_mapping.isNull())
+        return false;
+    return m_indexed < m_mapping->size;
+}
+
+void LicenseDocument::fetchMore(const QModelIndex &parent)
+{
+    if (parent.isValid())
+        return;
+    indexChunks(CHUNKS_PER_FETCH);
+}
@@ -0,0 +1,107 @@
+/*
+ * Copyright (C) 2016 Canonical Ltd
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+*/
+
+#ifndef LICENSEDOCUMENT_H
+#define LICENSEDOCUMENT_H
+
+#include <QAbstractListModel>
+#include <QAtomicInt>
+#include <QFutureWatcher>
+#include <QSharedPointer>
+#include <QVariant>
+#include <QVector>
+
+/* Exposes a copyright file as a list of paragraphs.  The file is memory
+ * mapped and split into chunks on demand (through fetchMore()), so only
+ * the paragraphs a view actually asks for are decoded and laid out. */
+class LicenseDocument : public QAbstractListModel
+{
+    Q_OBJECT
+
+    Q_PROPERTY(QString binary
+               READ binary
+               WRITE setBinary
+               NOTIFY binaryChanged)
+
+    Q_PROPERTY(bool valid
+               READ valid
+               NOTIFY validChanged)
+
+    Q_PROPERTY(bool searching
+               READ searching
+               NOTIFY searchingChanged)
+
+public:
+    enum Roles {
+        TextRole = Qt::UserRole + 1,
+        OffsetRole
+    };
+
+    explicit LicenseDocument(QObject *parent = 0);
+    ~LicenseDocument();
+
+    QString binary() const;
+    void setBinary(const QString &binary);
+    bool valid() const;
+    bool searching() const;
+
+    /* Starts a background, case-insensitive search for text.  Results are
+     * delivered through findFinished() as byte offsets into the file. */
+    Q_INVOKABLE void find(const QString &text);
+    Q_INVOKABLE void cancelFind();
+    /* Returns the row containing the given byte offset, indexing (and
+     * inserting) as many rows as needed to reach it. */
+    Q_INVOKABLE int rowForOffset(qint64 offset);
+
+    // implemented virtual methods from QAbstractListModel
+    int rowCount(const QModelIndex &parent = QModelIndex()) const;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const;
+    QHash<int, QByteArray> roleNames() const;
+    bool canFetchMore(const QModelIndex &parent) const;
+    void fetchMore(const QModelIndex &parent);
+
+    struct Mapping;
+
+Q_SIGNALS:
+    void binaryChanged();
+    void validChanged();
+    void searchingChanged();
+    void findFinished(const QString &text, const QVariantList &offsets);
+
+private Q_SLOTS:
+    void onFindFinished();
+
+private:
+    struct Chunk {
+        qint64 offset;
+        qint64 length;
+    };
+
+    void open();
+    int indexChunks(int count, qint64 untilOffset = -1);
+
+    QString m_binary;
+    QSharedPointer<Mapping> m_mapping;
+    QVector<Chunk> m_chunks;
+    qint64 m_indexed;
+
+    QString m_findText;
+    QSharedPointer<QAtomicInt> m_findCancelled;
+    QFutureWatcher<QList<qint64> > m_findWatcher;
+};
+
+#endif // LICENSEDOCUMENT_H
@@ -21,6 +21,8 @@
 #include "plugin.h"
 #include <QtQml>
 #include <QtQml/QQmlContext>
+#include "appstoragemodel.h"
+#include "licensedocument.h"
 #include "storageabout.h"
 
 void BackendPlugin::registerTypes(const char *uri)
@@ -28,6 +30,8 @@ void BackendPlugin::registerTypes(const char *uri)
     Q_ASSERT(uri == QLatin1String("Ubuntu.SystemSettings.StorageAbout"));
 
     qmlRegisterType<StorageAbout>(uri, 1, 0, "UbuntuStorageAboutPanel");
+    qmlRegisterType<LicenseDocument>(uri, 1, 0, "LicenseDocument");
+    qmlRegisterType<AppStorageModel>(uri, 1, 0, "AppStorageModel");
 }
 
 void BackendPlugin::initializeEngine(QQmlEngine *engine, const char *uri)
@@ -20,6 +20,7 @@
 */
 
 #include "storageabout.h"
+#include "deviceinfosnapshot.h"
 
 #include <QDebug>
 
@@ -43,13 +44,6 @@
 #include <QtGlobal>
 #include <QProcess>
 #include <QVariant>
-#include <hybris/properties/properties.h>
-#include <QDBusReply>
-
-namespace {
-    const QString PROPERTY_SERVICE_PATH = "/com/canonical/PropertyService";
-    const QString PROPERTY_SERVICE_OBJ = "com.canonical.PropertyService";
-}
 
 struct MeasureData {
     QSharedPointer<quint32> running;
@@ -143,93 +137,55 @@ StorageAbout::StorageAbout(QObject *parent) :
     m_picturesSize(0),
     m_otherSize(0),
     m_homeSize(0),
-    m_propertyService(new QDBusInterface(PROPERTY_SERVICE_OBJ,
-        PROPERTY_SERVICE_PATH,
-        PROPERTY_SERVICE_OBJ,
-        QDBusConnection::systemBus())),
+    m_deviceInfo(DeviceInfoSnapshot::instance()),
     m_cancellable(nullptr)
 {
+    /* The snapshot is gathered once per session in the background, the
+       properties are refreshed together when it is complete */
+    connect(m_deviceInfo, SIGNAL(ready()),
+            this, SIGNAL(deviceInfoChanged()));
+    connect(m_deviceInfo, SIGNAL(developerModeChanged()),
+            this, SIGNAL(developerModeChanged()));
 }
 
-QString StorageAbout::serialNumber()
+QObject *StorageAbout::deviceInfo() const
 {
+    return m_deviceInfo;
+}
 
-    if (m_serialNumber.isEmpty() || m_serialNumber.isNull())
-    {
-        char serialBuffer[PROP_VALUE_MAX];
-        property_get("ro.serialno", serialBuffer, "");
-        m_serialNumber = QString(serialBuffer);
-    }
-
-    return m_serialNumber;
+QString StorageAbout::serialNumber()
+{
+    return m_deviceInfo->serialNumber();
 }
 
 QString StorageAbout::vendorString()
 {
-    if (m_vendorString.isEmpty() || m_vendorString.isNull())
-    {
-        char manufacturerBuffer[PROP_VALUE_MAX];
-        char modelBuffer[PROP_VALUE_MAX];
-        property_get("ro.product.manufacturer", manufacturerBuffer, "");
-        property_get("ro.product.model", modelBuffer, "");
-        m_vendorString = QString("%1 %2").arg(manufacturerBuffer).arg(modelBuffer);
-    }
-
-    return m_vendorString;
+    return m_deviceInfo->vendorString();
 }
 
 QString StorageAbout::deviceBuildDisplayID()
 {
-
-    if (m_deviceBuildDisplayID.isEmpty() || m_deviceBuildDisplayID.isNull())
-    {
-        char serialBuffer[PROP_VALUE_MAX];
-        property_get("ro.build.display.id", serialBuffer, "");
-        m_deviceBuildDisplayID = QString(serialBuffer);
-    }
-
-    return m_deviceBuildDisplayID;
+    return m_deviceInfo->deviceBuildDisplayID();
 }
 
 QString StorageAbout::ubuntuBuildID()
 {
-    if (m_ubuntuBuildID.isEmpty() || m_ubuntuBuildID.isNull())
-    {
-        QFile file(qgetenv("SNAP").append("/etc/media-info"));
-        if (!file.exists())
-            return "";
-        file.open(QIODevice::ReadOnly | QIODevice::Text);
-        m_ubuntuBuildID = QString(file.readAll());
-        file.close();
-    }
-
-    return m_ubuntuBuildID;
+    return m_deviceInfo->ubuntuBuildID();
 }
 
 bool StorageAbout::getDeveloperModeCapable() const
 {
-    QDBusReply<bool> reply = m_propertyService->call("GetProperty", "adb");
-
-    if (reply.isValid())
-        return true;
-    return false;
+    return m_deviceInfo->developerModeCapable();
 }
 
 bool StorageAbout::getDeveloperMode()
 {
-    QDBusReply<bool> reply = m_propertyService->call("GetProperty", "adb");
-
-    if (reply.isValid()) {
-        return reply.value();
-    } else {
-        qWarning("devMode: no reply from dbus property service");
-        return false;
-    }
+    return m_deviceInfo->developerMode();
 }
 
 void StorageAbout::setDeveloperMode(bool mode)
 {
-    m_propertyService->call("SetProperty", "adb", mode);
+    m_deviceInfo->setDeveloperMode(mode);
 }
 
 QString StorageAbout::licenseInfo(const QString &subdir) const
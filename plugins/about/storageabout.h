@@ -27,20 +27,24 @@
 #include <QObject>
 #include <QProcess>
 #include <QVariant>
-#include <QDBusInterface>
 
+class DeviceInfoSnapshot;
 
 class StorageAbout : public QObject
 {
     Q_OBJECT
 
+    Q_PROPERTY(QObject* deviceInfo
+               READ deviceInfo
+               CONSTANT)
+
     Q_PROPERTY( QString serialNumber
                 READ serialNumber
-                CONSTANT)
+                NOTIFY deviceInfoChanged)
 
     Q_PROPERTY( QString vendorString
                 READ vendorString
-                CONSTANT)
+                NOTIFY deviceInfoChanged)
 
     Q_PROPERTY(QStringList mountedVolumes
                READ getMountedVolumes
@@ -64,22 +68,24 @@ class StorageAbout : public QObject
 
     Q_PROPERTY( QString deviceBuildDisplayID
                 READ deviceBuildDisplayID
-                CONSTANT)
+                NOTIFY deviceInfoChanged)
 
     Q_PROPERTY( QString ubuntuBuildID
                 READ ubuntuBuildID
-                CONSTANT)
+                NOTIFY deviceInfoChanged)
 
     Q_PROPERTY(bool developerMode
                READ getDeveloperMode
-               WRITE setDeveloperMode)
+               WRITE setDeveloperMode
+               NOTIFY developerModeChanged)
     Q_PROPERTY(bool developerModeCapable
                READ getDeveloperModeCapable
-                CONSTANT)
+               NOTIFY deviceInfoChanged)
 
 public:
     explicit StorageAbout(QObject *parent = 0);
     ~StorageAbout();
+    QObject *deviceInfo() const;
     QString serialNumber();
     QString vendorString();
     QString deviceBuildDisplayID();
@@ -102,24 +108,21 @@ public:
 Q_SIGNALS:
     void sortRoleChanged();
     void sizeReady();
+    void deviceInfoChanged();
+    void developerModeChanged();
 
 private:
     void prepareMountedVolumes();
     QStringList m_mountedVolumes;
-    QString m_serialNumber;
-    QString m_vendorString;
-    QString m_deviceBuildDisplayID;
-    QString m_ubuntuBuildID;
     quint64 m_moviesSize;
     quint64 m_audioSize;
     quint64 m_picturesSize;
     quint64 m_otherSize;
     quint64 m_homeSize;
+    DeviceInfoSnapshot *m_deviceInfo;
 
     QMap<QString, QString> m_mounts;
 
-    QScopedPointer<QDBusInterface> m_propertyService;
-
     GCancellable *m_cancellable;
 };
 
@@ -37,6 +37,9 @@ ItemPage {
     property var dialogPopupId
     property var currentDevice
 
+    // Covered by a device page or another panel
+    onVisibleChanged: backend.setPageVisible(visible)
+
     function finishDevicePairing() {
         if (root.dialogPopupId)
             PopupUtils.close(root.dialogPopupId)
@@ -338,6 +341,8 @@ ItemPage {
                     delegate: SettingsListItems.IconProgression {
                         iconSource: iconPath
                         text: getDisplayName(type, displayName)
+                        // Remembered from last time, BlueZ not asked yet
+                        enabled: !stale
                         onClicked: {
                             backend.setSelectedDevice(addressName);
                             pageStack.addPageToNextColumn(root,
@@ -374,6 +379,8 @@ ItemPage {
                     delegate: SettingsListItems.IconProgression {
                         iconSource: iconPath
                         text: getDisplayName(type, displayName)
+                        // Remembered from last time, BlueZ not asked yet
+                        enabled: !stale
                         onClicked: {
                             backend.setSelectedDevice(addressName);
                             pageStack.addPageToNextColumn(root,
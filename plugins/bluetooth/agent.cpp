@@ -40,6 +40,25 @@ void Agent::reject(QDBusMessage msg, const char *functionName)
   m_connection.send(msg.createErrorReply(name, text));
 }
 
+/**
+ * Answers the current D-Bus call later, through the returned tag.
+ */
+uint Agent::delayReply()
+{
+    const uint tag = m_tag++;
+
+    setDelayedReply(true);
+    assert(!m_delayedReplies.contains(tag));
+    m_delayedReplies[tag] = message();
+
+    return tag;
+}
+
+/**
+ * Returns the device at path, creating it if needed. A device created
+ * here has no properties yet: they are being fetched and it only becomes
+ * valid once Device::propertiesFetched() has been emitted.
+ */
 QSharedPointer<Device> Agent::findOrCreateDevice(const QDBusObjectPath &path)
 {
     auto device = m_devices.getDeviceFromPath(path.path());
@@ -56,6 +75,48 @@ QSharedPointer<Device> Agent::findOrCreateDevice(const QDBusObjectPath &path)
     return device;
 }
 
+/**
+ * Calls ready with the device at path as soon as it is valid. If its
+ * properties cannot be fetched the delayed reply for tag is rejected
+ * instead. Nothing here waits: BlueZ is answered from the delayed
+ * replies once the user made a choice.
+ */
+void Agent::whenDeviceReady(const QDBusObjectPath &path, uint tag,
+                            const char *functionName,
+                            std::function<void(Device*)> ready)
+{
+    auto device = findOrCreateDevice(path);
+
+    if (device && device->isValid()) {
+        ready(device.data());
+        return;
+    }
+
+    if (!device || device->hasFetchedProperties()) {
+        // request for an unknown device..?!
+        if (m_delayedReplies.contains(tag))
+            reject(m_delayedReplies.take(tag), functionName);
+        return;
+    }
+
+    // Holding the device keeps it alive until its properties arrive,
+    // even if the model dropped it in the meantime.
+    auto connection = QSharedPointer<QMetaObject::Connection>::create();
+    *connection = QObject::connect(device.data(), &Device::propertiesFetched, this,
+                                   [=]() {
+        QObject::disconnect(*connection);
+
+        // The request may have been answered or canceled while waiting.
+        if (!m_delayedReplies.contains(tag))
+            return;
+
+        if (device->isValid())
+            ready(device.data());
+        else
+            reject(m_delayedReplies.take(tag), functionName);
+    });
+}
+
 /***
 ****
 ***/
@@ -92,18 +153,12 @@ void Agent::Release()
  */
 void Agent::RequestConfirmation(const QDBusObjectPath &objectPath, uint passkey)
 {
-    if (auto device = findOrCreateDevice(objectPath)) {
-        const uint tag = m_tag++;
-
-        setDelayedReply(true);
-        assert(!m_delayedReplies.contains(tag));
-        m_delayedReplies[tag] = message();
+    const uint tag = delayReply();
 
+    whenDeviceReady(objectPath, tag, __func__, [=](Device *device) {
         QString passkeyStr = QString("%1").arg(passkey, 6, 10, QChar('0'));
-        Q_EMIT(passkeyConfirmationNeeded(tag, device.data(), passkeyStr));
-    } else { // confirmation requested for an unknown device..?!
-        reject(message(), __func__);
-    }
+        Q_EMIT(passkeyConfirmationNeeded(tag, device, passkeyStr));
+    });
 }
 
 /**
@@ -129,18 +184,11 @@ void Agent::confirmPasskey(uint tag, bool confirmed)
 
 QString Agent::RequestPinCode(const QDBusObjectPath &objectPath)
 {
-    if (auto device = findOrCreateDevice(objectPath)) {
-        const uint tag = m_tag++;
+    const uint tag = delayReply();
 
-        setDelayedReply(true);
-        assert(!m_delayedReplies.contains(tag));
-        m_delayedReplies[tag] = message();
-
-        Q_EMIT(pinCodeNeeded(tag, device.data()));
-
-    } else { // passkey requested for an unknown device..?!
-        reject(message(), __func__);
-    }
+    whenDeviceReady(objectPath, tag, __func__, [=](Device *device) {
+        Q_EMIT(pinCodeNeeded(tag, device));
+    });
 
   return 0;
 }
@@ -156,18 +204,11 @@ QString Agent::RequestPinCode(const QDBusObjectPath &objectPath)
  */
 unsigned int Agent::RequestPasskey(const QDBusObjectPath &objectPath)
 {
-    if (auto device = findOrCreateDevice(objectPath)) {
-        const uint tag = m_tag++;
-
-        setDelayedReply(true);
-        assert(!m_delayedReplies.contains(tag));
-        m_delayedReplies[tag] = message();
+    const uint tag = delayReply();
 
-        Q_EMIT(passkeyNeeded(tag, device.data()));
-
-    } else { // passkey requested for an unknown device..?!
-        reject(message(), __func__);
-    }
+    whenDeviceReady(objectPath, tag, __func__, [=](Device *device) {
+        Q_EMIT(passkeyNeeded(tag, device));
+    });
 
   return 0;
 }
@@ -219,21 +260,23 @@ void Agent::providePinCode(uint tag, bool confirmed, QString pinCode)
 
 void Agent::DisplayPinCode(const QDBusObjectPath &objectPath, QString pincode)
 {
-    if (auto device = findOrCreateDevice(objectPath)) {
-        Q_EMIT(displayPinCodeNeeded(device.data(), pincode));
-    } else {
-        reject(message(), __func__);
-    }
+    const uint tag = delayReply();
+
+    whenDeviceReady(objectPath, tag, __func__, [=](Device *device) {
+        m_connection.send(m_delayedReplies.take(tag).createReply());
+        Q_EMIT(displayPinCodeNeeded(device, pincode));
+    });
 }
 
 void Agent::DisplayPasskey(const QDBusObjectPath &objectPath, uint passkey, ushort entered)
 {
-    if (auto device = findOrCreateDevice(objectPath)) {
+    const uint tag = delayReply();
+
+    whenDeviceReady(objectPath, tag, __func__, [=](Device *device) {
+        m_connection.send(m_delayedReplies.take(tag).createReply());
         QString passkeyStr = QString("%1").arg(passkey, 6, 10, QChar('0'));
-        Q_EMIT(displayPasskeyNeeded(device.data(), passkeyStr, entered));
-    } else {
-        reject(message(), __func__);
-    }
+        Q_EMIT(displayPasskeyNeeded(device, passkeyStr, entered));
+    });
 }
 
 /**
@@ -252,18 +295,11 @@ void Agent::RequestAuthorization(const QDBusObjectPath &objectPath)
     qWarning() << "Authorization requested for device"
                << objectPath.path();
 
-    if (auto device = findOrCreateDevice(objectPath)) {
-        const uint tag = m_tag++;
-
-        setDelayedReply(true);
-        assert(!m_delayedReplies.contains(tag));
-        m_delayedReplies[tag] = message();
+    const uint tag = delayReply();
 
-        Q_EMIT(authorizationRequested(tag, device.data()));
-    }
-    else {
-        reject(message(), __func__);
-    }
+    whenDeviceReady(objectPath, tag, __func__, [=](Device *device) {
+        Q_EMIT(authorizationRequested(tag, device));
+    });
 }
 
 void Agent::authorizationRequestCallback(uint tag, bool allow)
@@ -21,6 +21,8 @@
 #ifndef USS_BLUETOOTH_AGENT_H
 #define USS_BLUETOOTH_AGENT_H
 
+#include <functional>
+
 #include <QObject>
 #include <QMap>
 #include <QSharedPointer>
@@ -76,7 +78,11 @@ private:
     void cancel(QDBusMessage msg, const char *functionName);
     void reject(QDBusMessage msg, const char *functionName);
 
+    uint delayReply();
     QSharedPointer<Device> findOrCreateDevice(const QDBusObjectPath &path);
+    void whenDeviceReady(const QDBusObjectPath &path, uint tag,
+                         const char *functionName,
+                         std::function<void(Device*)> ready);
 };
 
 Q_DECLARE_METATYPE(Agent*)
@@ -117,6 +117,17 @@ void Bluetooth::unblockDiscovery()
     m_devices.unblockDiscovery();
 }
 
+/* Discovery only runs while the page is shown */
+void Bluetooth::setPageVisible(bool visible)
+{
+    m_devices.setPageVisible(visible);
+}
+
+void Bluetooth::setDiscoveryTransport(const QString &transport)
+{
+    m_devices.setDiscoveryTransport(transport);
+}
+
 /***
 ****
 ***/
@@ -96,6 +96,8 @@ public:
     Q_INVOKABLE void resetSelectedDevice();
     Q_INVOKABLE void blockDiscovery();
     Q_INVOKABLE void unblockDiscovery();
+    Q_INVOKABLE void setPageVisible(bool visible);
+    Q_INVOKABLE void setDiscoveryTransport(const QString &transport);
     Q_INVOKABLE void startDiscovery();
     Q_INVOKABLE void stopDiscovery();
     Q_INVOKABLE void toggleDiscovery();
@@ -43,6 +43,13 @@ public Q_SLOTS: // METHODS
         return asyncCallWithArgumentList(QStringLiteral("RemoveDevice"), argumentList);
     }
 
+    inline QDBusPendingReply<> SetDiscoveryFilter(const QVariantMap &filter)
+    {
+        QList<QVariant> argumentList;
+        argumentList << QVariant::fromValue(filter);
+        return asyncCallWithArgumentList(QStringLiteral("SetDiscoveryFilter"), argumentList);
+    }
+
     inline QDBusPendingReply<> StartDiscovery()
     {
         QList<QVariant> argumentList;
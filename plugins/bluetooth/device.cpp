@@ -19,6 +19,7 @@
 
 #include "device.h"
 
+#include <QCollator>
 #include <QDBusReply>
 #include <QDebug> // qWarning()
 #include <QThread>
@@ -26,11 +27,49 @@
 
 #include "dbus-shared.h"
 
+// Shown until BlueZ tells us the real name.
+static const QString UNKNOWN_NAME("unknown");
+
 Device::Device(const QString &path, QDBusConnection &bus) :
-   m_name("unknown"),
+   m_name(UNKNOWN_NAME),
    m_strength(Device::None)
 {
+    updateSortKey();
     initDevice(path, bus);
+
+    QObject::connect(m_bluezDeviceProperties.data(), SIGNAL(PropertiesChanged(const QString&, const QVariantMap&, const QStringList&)),
+                     this, SLOT(slotPropertiesChanged(const QString&, const QVariantMap&, const QStringList&)));
+
+    fetchProperties();
+}
+
+Device::Device(const QString &path, QDBusConnection &bus, const QVariantMap &properties) :
+   m_name(UNKNOWN_NAME),
+   m_strength(Device::None)
+{
+    updateSortKey();
+    initDevice(path, bus);
+
+    if (properties.isEmpty()) {
+        fetchProperties();
+    } else {
+        setProperties(properties);
+        m_propertiesFetched = true;
+    }
+}
+
+Device::Device(const QVariantMap &cached) :
+   m_name(UNKNOWN_NAME),
+   m_strength(Device::None),
+   m_stale(true)
+{
+    updateSortKey();
+    setAddress(cached.value("address").toString());
+    setName(cached.value("name", m_name).toString());
+    setType(static_cast<Type>(cached.value("type", Type::Other).toInt()));
+    setIconName(cached.value("icon").toString());
+    setPaired(cached.value("paired").toBool());
+    setTrusted(cached.value("trusted").toBool());
 }
 
 void Device::initDevice(const QString &path, QDBusConnection &bus)
@@ -54,22 +93,23 @@ void Device::initDevice(const QString &path, QDBusConnection &bus)
 
     m_bluezDeviceProperties.reset(new FreeDesktopProperties(BLUEZ_SERVICE, path, bus));
 
-    QObject::connect(m_bluezDeviceProperties.data(), SIGNAL(PropertiesChanged(const QString&, const QVariantMap&, const QStringList&)),
-                     this, SLOT(slotPropertiesChanged(const QString&, const QVariantMap&, const QStringList&)));
-
     Q_EMIT(pathChanged());
+}
 
+void Device::fetchProperties()
+{
     watchCall(m_bluezDeviceProperties->GetAll(BLUEZ_DEVICE_IFACE), [=](QDBusPendingCallWatcher *watcher) {
         QDBusPendingReply<QVariantMap> reply = *watcher;
 
         if (reply.isError()) {
             qWarning() << "Failed to retrieve properties for device" << m_bluezDevice->path();
-            watcher->deleteLater();
-            return;
+        } else {
+            auto properties = reply.argumentAt<0>();
+            setProperties(properties);
         }
 
-        auto properties = reply.argumentAt<0>();
-        setProperties(properties);
+        m_propertiesFetched = true;
+        Q_EMIT(propertiesFetched());
 
         watcher->deleteLater();
     });
@@ -105,6 +145,9 @@ void Device::setConnectAfterPairing(bool value)
 
 void Device::disconnect()
 {
+    if (m_stale)
+        return;
+
     setConnection(Device::Disconnecting);
 
     QDBusPendingCall call = m_bluezDevice->Disconnect();
@@ -136,6 +179,9 @@ void Device::connectAfterPairing()
 
 void Device::pair()
 {
+    if (m_stale)
+        return;
+
     if (m_paired) {
         // If we are already paired we just have to make sure we
         // trigger the connection process if we have to
@@ -171,7 +217,7 @@ void Device::pair()
 
 void Device::cancelPairing()
 {
-   if (!m_isPairing)
+   if (!m_isPairing || m_stale)
       return;
 
     auto call = m_bluezDevice->asyncCall("CancelPairing");
@@ -201,7 +247,7 @@ void Device::connect()
     // here even if we're marked as connected as this still doesn't mean we're
     // connected on any profile. Calling org.bluez.Device1.Connect multiple
     // times doesn't hurt an will not fail.
-    if (m_isConnected && !m_connectAfterPairing)
+    if (m_stale || (m_isConnected && !m_connectAfterPairing))
        return;
 
     setConnection(Device::Connecting);
@@ -243,6 +289,9 @@ void Device::slotMakeTrustedDone(QDBusPendingCallWatcher *call)
 
 void Device::makeTrusted(bool trusted)
 {
+    if (m_stale)
+        return;
+
     auto call = m_bluezDeviceProperties->Set(BLUEZ_DEVICE_IFACE, "Trusted", QDBusVariant(trusted));
 
     auto watcher = new QDBusPendingCallWatcher(call, this);
@@ -254,6 +303,7 @@ void Device::setName(const QString &name)
 {
     if (m_name != name) {
         m_name = name;
+        updateSortKey();
         Q_EMIT(nameChanged());
     }
 }
@@ -270,6 +320,8 @@ void Device::setAddress(const QString &address)
 {
     if (m_address != address) {
         m_address = address;
+        if (m_name.isEmpty() || m_name == UNKNOWN_NAME)
+            updateSortKey();
         Q_EMIT(addressChanged());
     }
 }
@@ -307,6 +359,36 @@ void Device::setConnection(Connection connection)
     }
 }
 
+void Device::updateSortKey()
+{
+    static QCollator collator = []() {
+        QCollator c;
+        c.setCaseSensitivity(Qt::CaseInsensitive);
+        c.setNumericMode(true);
+        return c;
+    }();
+
+    const bool nameless = m_name.isEmpty() || m_name == UNKNOWN_NAME;
+    m_sortKey.reset(new QCollatorSortKey(
+        collator.sortKey(nameless ? m_address : m_name)));
+}
+
+int Device::compareName(const Device &other) const
+{
+    if (!m_sortKey || !other.m_sortKey)
+        return (m_sortKey ? 1 : 0) - (other.m_sortKey ? 1 : 0);
+
+    return m_sortKey->compare(*other.m_sortKey);
+}
+
+void Device::setStrength(Strength strength)
+{
+    if (m_strength != strength) {
+        m_strength = strength;
+        Q_EMIT(strengthChanged());
+    }
+}
+
 void Device::updateIcon()
 {
     /* bluez-provided icon is unreliable? In testing I'm getting
@@ -390,8 +472,8 @@ void Device::updateProperty(const QString &key, const QVariant &value)
         m_fallbackIconName = value.toString();
         updateIcon ();
     } else if (key == "RSSI") {
-        m_strength = getStrengthFromRssi(value.toInt());
-        Q_EMIT(strengthChanged());
+        // Only a change of bucket is worth telling anyone about.
+        setStrength(getStrengthFromRssi(value.toInt()));
     }
 }
 
@@ -20,6 +20,7 @@
 #ifndef USS_BLUETOOTH_DEVICE_H
 #define USS_BLUETOOTH_DEVICE_H
 
+#include <QCollatorSortKey>
 #include <QDBusConnection>
 #include <QDBusInterface>
 #include <QDBusPendingCallWatcher>
@@ -97,6 +98,7 @@ Q_SIGNALS:
     void strengthChanged();
     void deviceChanged(); // catchall for any change
     void pairingDone(bool success);
+    void propertiesFetched(); // initial GetAll answered, successfully or not
 
 public:
     const QString& getName() const { return m_name; }
@@ -125,6 +127,9 @@ public:
     QScopedPointer<BluezDevice1> m_bluezDevice;
     QScopedPointer<FreeDesktopProperties> m_bluezDeviceProperties;
     bool m_isPairing = false;
+    bool m_propertiesFetched = false;
+    bool m_stale = false;
+    QScopedPointer<QCollatorSortKey> m_sortKey;
 
   protected:
     void setName(const QString &name);
@@ -137,12 +142,25 @@ public:
     void setStrength(Strength strength);
     void updateIcon();
     void updateConnection();
+    void updateSortKey();
 
   public:
     Device() {}
+    /* A standalone device: fetches and watches its own properties. */
     Device(const QString &path, QDBusConnection &bus);
+    /* A device fed by DeviceModel, which already holds its properties
+       and forwards their changes. Only fetches them if none are given. */
+    Device(const QString &path, QDBusConnection &bus, const QVariantMap &properties);
+    /* A stale device restored from DeviceModel's cache: it has no BlueZ
+       object until the model replaces it with the live one. */
+    explicit Device(const QVariantMap &cached);
     ~Device() {}
-    bool isValid() const { return true; }
+    /* The device is valid once BlueZ told us its address. */
+    bool isValid() const { return !m_address.isEmpty(); }
+    bool hasFetchedProperties() const { return m_propertiesFetched; }
+    bool isStale() const { return m_stale; }
+    /* Collation order of the raw names, address if nameless. */
+    int compareName(const Device &other) const;
     void pair();
     Q_INVOKABLE void cancelPairing();
     void connect();
@@ -158,6 +176,7 @@ public:
 
   private:
     void initDevice(const QString &path, QDBusConnection &bus);
+    void fetchProperties();
     void updateProperties(QSharedPointer<QDBusInterface>);
     void updateProperty(const QString &key, const QVariant &value);
     static Type getTypeFromClass(quint32 bluetoothClass);
@@ -22,8 +22,7 @@
 
 #include <QDBusReply>
 #include <QDebug>
-#include <QTime>
-#include <QCoreApplication>
+#include <QStandardPaths>
 
 #include "dbus-shared.h"
 
@@ -31,6 +30,29 @@ namespace
 {
   const int SCANNING_ACTIVE_DURATION_MSEC = (30 * 1000);
   const int SCANNING_IDLE_DURATION_MSEC = (10 * 1000);
+  // Each window without new devices doubles the gap up to this.
+  const int SCANNING_IDLE_MAX_DURATION_MSEC = (5 * 60 * 1000);
+  // Inquiry competes with 2.4 GHz wifi and the battery; be briefer
+  // and ignore far away devices when not charging.
+  const int SCANNING_ACTIVE_BATTERY_DURATION_MSEC = (15 * 1000);
+  const int SCANNING_IDLE_BATTERY_DURATION_MSEC = (20 * 1000);
+  const qint16 SCANNING_BATTERY_MIN_RSSI = -80;
+
+  // Writes of the device cache are batched over this long.
+  const int CACHE_STORE_DELAY_MSEC = (2 * 1000);
+
+  const char *UPOWER_SERVICE = "org.freedesktop.UPower";
+  const char *UPOWER_PATH = "/org/freedesktop/UPower";
+  const char *UPOWER_IFACE = "org.freedesktop.UPower";
+  // Changes are delivered at most once per frame.
+  const int CHANGE_FLUSH_INTERVAL_MSEC = 16;
+
+  uint roleBit(int role)
+  {
+      if (role == Qt::DisplayRole)
+          return 1;
+      return 1 << (role - DeviceModel::TypeRole + 1);
+  }
 }
 
 DeviceModel::DeviceModel(QDBusConnection &dbus, QObject *parent):
@@ -43,8 +65,20 @@ DeviceModel::DeviceModel(QDBusConnection &dbus, QObject *parent):
     m_isDiscovering(false),
     m_isDiscoverable(false),
     m_discoveryBlockCount(0),
-    m_activeDevices(0)
+    m_activeDevices(0),
+    m_idleDuration(SCANNING_IDLE_DURATION_MSEC),
+    m_discoveryTransport("auto"),
+    m_cache(QStandardPaths::writableLocation(QStandardPaths::CacheLocation)
+            + "/bluetooth-devices.ini", QSettings::IniFormat)
 {
+    m_cacheTimer.setSingleShot(true);
+    m_cacheTimer.setInterval(CACHE_STORE_DELAY_MSEC);
+    connect(&m_cacheTimer, SIGNAL(timeout()), this, SLOT(slotStoreCachedDevices()));
+
+    // Before anything is asked from BlueZ, so the known devices are
+    // there for the first frame.
+    loadCachedDevices();
+
     if (m_bluezManager.isValid()) {
 
         connect(&m_bluezManager, SIGNAL(InterfacesAdded(const QDBusObjectPath&, InterfaceList)),
@@ -53,12 +87,19 @@ DeviceModel::DeviceModel(QDBusConnection &dbus, QObject *parent):
         connect(&m_bluezManager, SIGNAL(InterfacesRemoved(const QDBusObjectPath&, const QStringList&)),
                 this, SLOT(slotInterfacesRemoved(const QDBusObjectPath&, const QStringList&)));
 
+        // A single match rule for the property changes of every device,
+        // dispatched through the path index, rather than one per device.
+        m_dbus.connect(BLUEZ_SERVICE, QString(), "org.freedesktop.DBus.Properties",
+                       "PropertiesChanged", QStringList() << BLUEZ_DEVICE_IFACE, QString(),
+                       this, SLOT(slotDevicePropertiesChanged(const QString&, const QVariantMap&, const QStringList&, const QDBusMessage&)));
+
         watchCall(m_bluezManager.GetManagedObjects(), [=](QDBusPendingCallWatcher *watcher) {
             QDBusPendingReply<ManagedObjectList> reply = *watcher;
 
             if (reply.isError()) {
                 qWarning() << "Failed to retrieve list of managed objects from BlueZ service: "
                            << reply.error().message();
+                dropStaleDevices();
                 watcher->deleteLater();
                 return;
             }
@@ -74,11 +115,19 @@ DeviceModel::DeviceModel(QDBusConnection &dbus, QObject *parent):
                 // Ok, here we've found an adapter. As we don't expect multiple at the
                 // moment we just take the first one we find.
                 setAdapterFromPath(path.path(), ifaces.value(BLUEZ_ADAPTER_IFACE));
+                // The reply already holds every device's properties.
+                addDevices(objectList);
                 break;
             }
 
+            // Without an adapter the cached devices cannot be confirmed.
+            if (!m_bluezAdapter)
+                dropStaleDevices();
+
             watcher->deleteLater();
         });
+    } else {
+        dropStaleDevices();
     }
 
     if (m_bluezAgentManager.isValid()) {
@@ -109,10 +158,18 @@ DeviceModel::DeviceModel(QDBusConnection &dbus, QObject *parent):
     }
 
     connect(&m_discoveryTimer, SIGNAL(timeout()), this, SLOT(slotDiscoveryTimeout()));
+    watchPowerSource();
+
+    m_changeTimer.setSingleShot(true);
+    m_changeTimer.setInterval(CHANGE_FLUSH_INTERVAL_MSEC);
+    connect(&m_changeTimer, SIGNAL(timeout()), this, SLOT(slotFlushChanges()));
 }
 
 DeviceModel::~DeviceModel()
 {
+    if (m_cacheTimer.isActive())
+        slotStoreCachedDevices();
+
     clearAdapter();
 
     qWarning() << "Releasing device model ..";
@@ -155,8 +212,12 @@ void DeviceModel::slotInterfacesAdded(const QDBusObjectPath &objectPath, Interfa
 
     if (!m_bluezAdapter) {
         // Maybe we have a new adapter we can start to use?
-        if (ifacesAndProps.contains(BLUEZ_ADAPTER_IFACE))
+        if (ifacesAndProps.contains(BLUEZ_ADAPTER_IFACE)) {
             setAdapterFromPath(candidatedPath, ifacesAndProps.value(BLUEZ_ADAPTER_IFACE));
+            // Shown again until the listing confirms or drops them.
+            loadCachedDevices();
+            updateDevices();
+        }
 
         return;
     }
@@ -199,22 +260,203 @@ void DeviceModel::slotInterfacesRemoved(const QDBusObjectPath &objectPath, const
         removeRow(row);
 }
 
+void DeviceModel::slotDevicePropertiesChanged(const QString &interface,
+                                              const QVariantMap &changedProperties,
+                                              const QStringList &invalidatedProperties,
+                                              const QDBusMessage &message)
+{
+    Q_UNUSED(invalidatedProperties);
+
+    if (interface != BLUEZ_DEVICE_IFACE)
+        return;
+
+    auto device = m_devicesByPath.value(message.path());
+    if (device)
+        device->setProperties(changedProperties);
+}
+
 int DeviceModel::findRowFromAddress(const QString &address) const
 {
-    for (int i=0, n=m_devices.size(); i<n; i++)
-        if (m_devices[i]->getAddress() == address)
-            return i;
+    return m_rowByAddress.value(address, -1);
+}
+
+int DeviceModel::findRowFromDevice(const Device *device) const
+{
+    auto it = m_rowByDevice.constFind(device);
+    return it != m_rowByDevice.constEnd() ? it->row : -1;
+}
+
+void DeviceModel::indexRow(int row)
+{
+    const QSharedPointer<Device> &device = m_devices[row];
+
+    DeviceIndex index;
+    index.row = row;
+    index.address = device->getAddress();
+    m_rowByDevice.insert(device.data(), index);
+
+    // Devices created for agent requests have no address until their
+    // properties arrive.
+    if (!index.address.isEmpty())
+        m_rowByAddress.insert(index.address, row);
 
-    return -1;
+    // Devices loaded from the cache have no path until BlueZ lists them.
+    if (!device->getPath().isEmpty())
+        m_devicesByPath.insert(device->getPath(), device);
+}
+
+void DeviceModel::unindexRow(int row)
+{
+    const QSharedPointer<Device> &device = m_devices[row];
+
+    auto it = m_rowByDevice.find(device.data());
+    if (it != m_rowByDevice.end()) {
+        if (m_rowByAddress.value(it->address, -1) == row)
+            m_rowByAddress.remove(it->address);
+        m_rowByDevice.erase(it);
+    }
+
+    if (device->getPath().isEmpty())
+        return;
+
+    auto byPath = m_devicesByPath.find(device->getPath());
+    if (byPath != m_devicesByPath.end() && *byPath == device)
+        m_devicesByPath.erase(byPath);
+}
+
+void DeviceModel::clearDevices()
+{
+    if (m_cacheTimer.isActive()) {
+        m_cacheTimer.stop();
+        slotStoreCachedDevices();
+    }
+
+    beginResetModel();
+    m_changedRoles.clear();
+    m_devices.clear();
+    m_rowByDevice.clear();
+    m_rowByAddress.clear();
+    m_devicesByPath.clear();
+    endResetModel();
 }
 
 void DeviceModel::restartDiscoveryTimer()
 {
-    if (m_discoveryBlockCount > 0)
+    if (m_discoveryBlockCount > 0 || !m_pageVisible)
+        return;
+
+    if (m_isDiscovering)
+        m_discoveryTimer.start(m_onBattery ? SCANNING_ACTIVE_BATTERY_DURATION_MSEC
+                                           : SCANNING_ACTIVE_DURATION_MSEC);
+    else
+        m_discoveryTimer.start(m_idleDuration);
+}
+
+void DeviceModel::resetDiscoveryBackoff()
+{
+    m_idleDuration = m_onBattery ? SCANNING_IDLE_BATTERY_DURATION_MSEC
+                                 : SCANNING_IDLE_DURATION_MSEC;
+    m_foundDuringWindow = false;
+}
+
+void DeviceModel::setPageVisible(bool visible)
+{
+    if (m_pageVisible == visible)
         return;
 
-    m_discoveryTimer.start (m_isDiscovering ? SCANNING_ACTIVE_DURATION_MSEC
-                                   : SCANNING_IDLE_DURATION_MSEC);
+    m_pageVisible = visible;
+
+    if (!visible) {
+        stopDiscovery();
+        m_discoveryTimer.stop();
+    } else {
+        // Someone is looking again: scan now, whatever we learned before.
+        resetDiscoveryBackoff();
+        if (m_discoveryBlockCount == 0)
+            startDiscovery();
+    }
+}
+
+/* "auto", "bredr" or "le", as understood by BlueZ' SetDiscoveryFilter. */
+void DeviceModel::setDiscoveryTransport(const QString &transport)
+{
+    if (m_discoveryTransport == transport)
+        return;
+
+    m_discoveryTransport = transport;
+
+    if (m_isDiscovering)
+        applyDiscoveryFilter();
+}
+
+void DeviceModel::applyDiscoveryFilter()
+{
+    if (!m_bluezAdapter || !m_discoveryFilterSupported)
+        return;
+
+    QVariantMap filter;
+    filter.insert("Transport", m_discoveryTransport);
+    if (m_onBattery)
+        filter.insert("RSSI", QVariant::fromValue(SCANNING_BATTERY_MIN_RSSI));
+
+    watchCall(m_bluezAdapter->SetDiscoveryFilter(filter), [=](QDBusPendingCallWatcher *watcher) {
+        QDBusPendingReply<void> reply = *watcher;
+        if (reply.isError()) {
+            // BlueZ before 5.28 has no discovery filters.
+            if (reply.error().type() == QDBusError::UnknownMethod)
+                m_discoveryFilterSupported = false;
+            else
+                qWarning() << "Failed to set discovery filter:"
+                           << reply.error().message();
+        }
+
+        watcher->deleteLater();
+    });
+}
+
+void DeviceModel::watchPowerSource()
+{
+    m_dbus.connect(UPOWER_SERVICE, UPOWER_PATH, "org.freedesktop.DBus.Properties",
+                   "PropertiesChanged", this,
+                   SLOT(slotPowerSourceChanged(const QString&, const QVariantMap&, const QStringList&)));
+
+    QDBusMessage msg = QDBusMessage::createMethodCall(UPOWER_SERVICE, UPOWER_PATH,
+                                                      "org.freedesktop.DBus.Properties",
+                                                      "Get");
+    msg << QString(UPOWER_IFACE) << QString("OnBattery");
+
+    watchCall(m_dbus.asyncCall(msg), [=](QDBusPendingCallWatcher *watcher) {
+        QDBusPendingReply<QDBusVariant> reply = *watcher;
+
+        // Without UPower we behave as if on mains power.
+        if (!reply.isError()) {
+            QVariantMap changed;
+            changed.insert("OnBattery", reply.value().variant());
+            slotPowerSourceChanged(UPOWER_IFACE, changed, QStringList());
+        }
+
+        watcher->deleteLater();
+    });
+}
+
+void DeviceModel::slotPowerSourceChanged(const QString &interface,
+                                         const QVariantMap &changedProperties,
+                                         const QStringList &invalidatedProperties)
+{
+    Q_UNUSED(invalidatedProperties);
+
+    if (interface != UPOWER_IFACE || !changedProperties.contains("OnBattery"))
+        return;
+
+    const bool onBattery = changedProperties.value("OnBattery").toBool();
+    if (onBattery == m_onBattery)
+        return;
+
+    m_onBattery = onBattery;
+    resetDiscoveryBackoff();
+
+    if (m_isDiscovering)
+        applyDiscoveryFilter();
 }
 
 void DeviceModel::setDiscovering(bool value)
@@ -244,7 +486,11 @@ void DeviceModel::stopDiscovery()
 
 void DeviceModel::startDiscovery()
 {
-    if (m_bluezAdapter && m_isPowered && !m_isDiscovering) {
+    if (m_bluezAdapter && m_isPowered && !m_isDiscovering && m_pageVisible) {
+
+        // Queued before StartDiscovery on the same connection, so BlueZ
+        // applies it to this discovery session.
+        applyDiscoveryFilter();
 
         watchCall(m_bluezAdapter->StartDiscovery(), [=](QDBusPendingCallWatcher *watcher) {
             QDBusPendingReply<void> reply = *watcher;
@@ -268,6 +514,15 @@ void DeviceModel::toggleDiscovery()
 
 void DeviceModel::slotDiscoveryTimeout()
 {
+    if (isDiscovering()) {
+        // Back off once windows stop turning up new devices.
+        if (m_foundDuringWindow)
+            resetDiscoveryBackoff();
+        else
+            m_idleDuration = qMin(m_idleDuration * 2, SCANNING_IDLE_MAX_DURATION_MSEC);
+        m_foundDuringWindow = false;
+    }
+
     toggleDiscovery();
 }
 
@@ -283,9 +538,7 @@ void DeviceModel::clearAdapter()
         m_bluezAdapterProperties.reset(0);
         m_adapterName.clear();
 
-        beginResetModel();
-        m_devices.clear();
-        endResetModel();
+        clearDevices();
     }
 }
 
@@ -302,7 +555,6 @@ void DeviceModel::setAdapterFromPath(const QString &path, const QVariantMap &pro
         m_bluezAdapterProperties.reset(adapterProperties);
 
         startDiscovery();
-        updateDevices();
 
         setProperties(properties);
 
@@ -335,29 +587,90 @@ void DeviceModel::updateDevices()
         if (reply.isError()) {
             qWarning() << "Failed to retrieve list of managed objects from BlueZ service: "
                        << reply.error().message();
-            watcher->deleteLater();
-            return;
+            dropStaleDevices();
+        } else {
+            addDevices(reply.argumentAt<0>());
         }
 
-        auto objectList = reply.argumentAt<0>();
+        watcher->deleteLater();
+    });
+}
 
-        for (auto objectPath : objectList.keys()) {
-            auto candidatePath = objectPath.path();
+void DeviceModel::addDevices(const ManagedObjectList &objects)
+{
+    if (!m_bluezAdapter)
+        return;
 
-            if (!candidatePath.startsWith(m_bluezAdapter->path()))
-                continue;
+    for (auto it = objects.constBegin(); it != objects.constEnd(); ++it) {
+        auto candidatePath = it.key().path();
 
-            InterfaceList ifaces = objectList.value(objectPath);
+        if (!candidatePath.startsWith(m_bluezAdapter->path()))
+            continue;
 
-            if (!ifaces.contains(BLUEZ_DEVICE_IFACE))
-                continue;
+        if (!it.value().contains(BLUEZ_DEVICE_IFACE))
+            continue;
 
-            auto properties = ifaces.value(BLUEZ_DEVICE_IFACE);
+        addDevice(candidatePath, it.value().value(BLUEZ_DEVICE_IFACE));
+    }
 
-            addDevice(candidatePath, properties);
-        }
+    // Whatever BlueZ did not list is gone, e.g. unpaired meanwhile.
+    dropStaleDevices();
 
-    });
+    // Only now may what is remembered change: cached devices dropped
+    // for want of an answer are not known to be gone.
+    m_devicesListed = true;
+    m_cacheTimer.start();
+}
+
+void DeviceModel::loadCachedDevices()
+{
+    m_devicesListed = false;
+
+    const int size = m_cache.beginReadArray("devices");
+    for (int i = 0; i < size; i++) {
+        m_cache.setArrayIndex(i);
+
+        QVariantMap cached;
+        Q_FOREACH(const QString &key, m_cache.childKeys())
+            cached.insert(key, m_cache.value(key));
+
+        QSharedPointer<Device> device(new Device(cached));
+        if (device->isValid())
+            addDevice(device);
+    }
+    m_cache.endArray();
+}
+
+void DeviceModel::dropStaleDevices()
+{
+    for (int row = m_devices.size() - 1; row >= 0; row--)
+        if (m_devices[row]->isStale())
+            removeRow(row);
+}
+
+void DeviceModel::slotStoreCachedDevices()
+{
+    if (!m_devicesListed)
+        return;
+
+    m_cache.remove("devices");
+    m_cache.beginWriteArray("devices");
+
+    int i = 0;
+    for (const auto &device : m_devices) {
+        if (!device->isPaired() && !device->isTrusted())
+            continue;
+
+        m_cache.setArrayIndex(i++);
+        m_cache.setValue("address", device->getAddress());
+        m_cache.setValue("name", device->getName());
+        m_cache.setValue("icon", device->getIconName());
+        m_cache.setValue("type", int(device->getType()));
+        m_cache.setValue("paired", device->isPaired());
+        m_cache.setValue("trusted", device->isTrusted());
+    }
+
+    m_cache.endArray();
 }
 
 void DeviceModel::setProperties(const QMap<QString,QVariant> &properties)
@@ -498,44 +811,41 @@ void DeviceModel::slotDeviceConnectionChanged()
 
 QSharedPointer<Device> DeviceModel::addDevice(const QString &path, const QVariantMap &properties)
 {
-    QSharedPointer<Device> device(new Device(path, m_dbus));
-    device->setProperties(properties);
-
-    // The device is valid when the right properties are set for it. The
-    // code below makes sure that the right properties are set as in certain
-    // situations it happens with a delay.
-    //
-    // In case this function is called from FindOrCreateDevice() context
-    // the properties are not yet known. Of course the device will become
-    // valid once the device properties are gathered however this is done
-    // asynchronously, in the Device class constructor, and it takes a
-    // while. This is a problem in certain situations and as a consequence
-    // the pin code request is rejected and the pairing denied. To
-    // workaround this unwanted behavior we assume that at this point it is
-    // just a matter of time for the device to become valid and we wait a
-    // bit here. This is safe because in any other case the properties are
-    // already updated.
-    uint8_t tries = 0;
-    while (!device->isValid() && tries < 10) {
-        const QTime timeout = QTime::currentTime().addMSecs(100);
-        while (QTime::currentTime() < timeout)
-            QCoreApplication::processEvents(QEventLoop::AllEvents, 100);
-        tries++;
-    }
-
-    // However if the above fails there is nothing else that can be done
-    // than returning the nullptr.
-    if (!device->isValid())
-        return QSharedPointer<Device>(nullptr);
-
-    QObject::connect(device.data(), SIGNAL(deviceChanged()),
-                     this, SLOT(slotDeviceChanged()));
+    QSharedPointer<Device> device = createDevice(path, properties);
+    return addDevice(device);
+}
+
+QSharedPointer<Device> DeviceModel::createDevice(const QString &path, const QVariantMap &properties)
+{
+    QSharedPointer<Device> device(new Device(path, m_dbus, properties));
+
+    const Device *changed = device.data();
+    QObject::connect(changed, &Device::nameChanged, this,
+                     [=]() { markChanged(changed, Qt::DisplayRole); });
+    QObject::connect(changed, &Device::pairedChanged, this,
+                     [=]() { markChanged(changed, Qt::DisplayRole); });
+    QObject::connect(changed, &Device::addressChanged, this, [=]() {
+        markChanged(changed, Qt::DisplayRole);
+        markChanged(changed, AddressRole);
+    });
+    QObject::connect(changed, &Device::iconNameChanged, this,
+                     [=]() { markChanged(changed, IconRole); });
+    QObject::connect(changed, &Device::typeChanged, this,
+                     [=]() { markChanged(changed, TypeRole); });
+    QObject::connect(changed, &Device::strengthChanged, this,
+                     [=]() { markChanged(changed, StrengthRole); });
+    QObject::connect(changed, &Device::connectionChanged, this,
+                     [=]() { markChanged(changed, ConnectionRole); });
+    QObject::connect(changed, &Device::trustedChanged, this,
+                     [=]() { markChanged(changed, TrustedRole); });
+    QObject::connect(device.data(), SIGNAL(addressChanged()),
+                     this, SLOT(slotDeviceAddressChanged()));
     QObject::connect(device.data(), SIGNAL(pairingDone(bool)),
                      this, SLOT(slotDevicePairingDone(bool)));
     QObject::connect(device.data(), SIGNAL(connectionChanged()),
                      this, SLOT(slotDeviceConnectionChanged()));
 
-    return addDevice(device);
+    return device;
 }
 
 QSharedPointer<Device> DeviceModel::addDevice(QSharedPointer<Device> &device)
@@ -543,15 +853,23 @@ QSharedPointer<Device> DeviceModel::addDevice(QSharedPointer<Device> &device)
     int row = findRowFromAddress(device->getAddress());
 
     if (row >= 0) { // update existing device
+        m_changedRoles.remove(m_devices[row].data());
+        unindexRow(row);
         m_devices[row] = device;
+        indexRow(row);
         emitRowChanged(row);
     } else { // add new device
+        m_foundDuringWindow = true;
         row = m_devices.size();
         beginInsertRows(QModelIndex(), row, row);
         m_devices.append(device);
+        indexRow(row);
         endInsertRows();
     }
 
+    if (!device->isStale())
+        m_cacheTimer.start();
+
     return device;
 }
 
@@ -559,7 +877,18 @@ void DeviceModel::removeRow(int row)
 {
     if (0<=row && row<m_devices.size()) {
         beginRemoveRows(QModelIndex(), row, row);
+        m_changedRoles.remove(m_devices[row].data());
+        unindexRow(row);
         m_devices.removeAt(row);
+        m_cacheTimer.start();
+
+        // Rows below moved up by one.
+        for (int i=row, n=m_devices.size(); i<n; i++) {
+            DeviceIndex &index = m_rowByDevice[m_devices[i].data()];
+            index.row = i;
+            if (!index.address.isEmpty())
+                m_rowByAddress[index.address] = i;
+        }
         endRemoveRows();
     }
 }
@@ -572,19 +901,49 @@ void DeviceModel::emitRowChanged(int row)
     }
 }
 
-void DeviceModel::slotDeviceChanged()
+void DeviceModel::markChanged(const Device *device, int role)
+{
+    m_changedRoles[device] |= roleBit(role);
+
+    if (role != StrengthRole && role != ConnectionRole)
+        m_cacheTimer.start();
+
+    if (!m_changeTimer.isActive())
+        m_changeTimer.start();
+}
+
+void DeviceModel::slotFlushChanges()
+{
+    const QHash<const Device*, uint> changes = m_changedRoles;
+    m_changedRoles.clear();
+
+    for (auto it = changes.constBegin(); it != changes.constEnd(); ++it) {
+        const int row = findRowFromDevice(it.key());
+        if (row == -1)
+            continue;
+
+        QVector<int> roles;
+        if (it.value() & roleBit(Qt::DisplayRole))
+            roles.append(Qt::DisplayRole);
+        for (int role = TypeRole; role <= LastRole; role++)
+            if (it.value() & roleBit(role))
+                roles.append(role);
+
+        QModelIndex qmi = index(row, 0);
+        Q_EMIT(dataChanged(qmi, qmi, roles));
+    }
+}
+
+void DeviceModel::slotDeviceAddressChanged()
 {
     const Device * device = qobject_cast<Device*>(sender());
 
-    // find the row that goes with this device
-    int row = -1;
-    if (device != nullptr)
-        for (int i=0, n=m_devices.size(); row==-1 && i<n; i++)
-            if (m_devices[i].data() == device)
-                row = i;
+    const int row = findRowFromDevice(device);
+    if (row == -1)
+        return;
 
-    if (row != -1)
-        emitRowChanged(row);
+    unindexRow(row);
+    indexRow(row);
 }
 
 QSharedPointer<Device> DeviceModel::getDeviceFromAddress(const QString &address)
@@ -598,20 +957,45 @@ QSharedPointer<Device> DeviceModel::getDeviceFromAddress(const QString &address)
     return device;
 }
 
-QSharedPointer<Device> DeviceModel::getDeviceFromPath(const QString &path)
+const Device *DeviceModel::deviceAt(int row) const
 {
-    for (auto device : m_devices)
-        if (device->getPath() == path)
-            return device;
+    if (row < 0 || row >= m_devices.size())
+        return nullptr;
 
-    return QSharedPointer<Device>();
+    return m_devices[row].data();
+}
+
+QSharedPointer<Device> DeviceModel::getDeviceFromPath(const QString &path)
+{
+    return m_devicesByPath.value(path);
 }
 
 QSharedPointer<Device> DeviceModel::addDeviceFromPath(const QDBusObjectPath &path)
 {
     qWarning() << "Creating device object for path" << path.path();
     QVariantMap noProps;
-    return addDevice(path.path(), noProps);
+    QSharedPointer<Device> device = createDevice(path.path(), noProps);
+
+    // Not a row until its properties arrive and make it valid, which
+    // callers wait for through Device::propertiesFetched(); until then
+    // only they and the path index hold it.
+    m_devicesByPath.insert(path.path(), device);
+
+    const Device *pending = device.data();
+    QObject::connect(pending, &Device::propertiesFetched, this, [=]() {
+        auto it = m_devicesByPath.find(path.path());
+        // Announced by BlueZ, or cleared with the adapter, meanwhile.
+        if (it == m_devicesByPath.end() || it->data() != pending)
+            return;
+
+        QSharedPointer<Device> fetched = *it;
+        if (fetched->isValid())
+            addDevice(fetched);
+        else
+            m_devicesByPath.erase(it);
+    });
+
+    return device;
 }
 
 void DeviceModel::slotRemoveFinished(QDBusPendingCallWatcher *call)
@@ -657,6 +1041,7 @@ QHash<int,QByteArray> DeviceModel::roleNames() const
         names[ConnectionRole] = "connection";
         names[AddressRole] = "addressName";
         names[TrustedRole] = "trusted";
+        names[StaleRole] = "stale";
     }
 
     return names;
@@ -707,36 +1092,82 @@ QVariant DeviceModel::data(const QModelIndex &index, int role) const
         case TrustedRole:
             ret = device->isTrusted();
             break;
+
+        case StaleRole:
+            ret = device->isStale();
+            break;
         }
     }
 
     return ret;
 }
 
+void DeviceFilter::setSourceModel(QAbstractItemModel *sourceModel)
+{
+    m_deviceModel = qobject_cast<DeviceModel*>(sourceModel);
+    QSortFilterProxyModel::setSourceModel(sourceModel);
+}
+
+/* Only rows already mapped need filtering again; before a source model
+   is set the criteria are simply recorded. */
+void DeviceFilter::filterChanged()
+{
+    if (sourceModel())
+        invalidateFilter();
+}
+
 void DeviceFilter::filterOnType(QVector<Device::Type> types)
 {
+    if (m_typeEnabled && m_types == types)
+        return;
+
     m_types = types;
     m_typeEnabled = true;
-    invalidateFilter();
+    filterChanged();
 }
 
 void DeviceFilter::filterOnConnections(Device::Connections connections)
 {
+    if (m_connectionsEnabled && m_connections == connections)
+        return;
+
     m_connections = connections;
     m_connectionsEnabled = true;
-    invalidateFilter();
+    filterChanged();
 }
 
 void DeviceFilter::filterOnTrusted(bool trusted)
 {
+    if (m_trustedEnabled && m_trustedFilter == trusted)
+        return;
+
     m_trustedEnabled = true;
     m_trustedFilter = trusted;
-    invalidateFilter();
+    filterChanged();
+}
+
+bool DeviceFilter::acceptsDevice(const Device &device) const
+{
+    if (m_typeEnabled && !m_types.contains(device.getType()))
+        return false;
+
+    if (m_connectionsEnabled && !(m_connections & device.getConnection()))
+        return false;
+
+    if (m_trustedEnabled && device.isTrusted() != m_trustedFilter)
+        return false;
+
+    return true;
 }
 
 bool DeviceFilter::filterAcceptsRow(int sourceRow,
                                     const QModelIndex &sourceParent) const
 {
+    if (m_deviceModel) {
+        const Device *device = m_deviceModel->deviceAt(sourceRow);
+        return device && acceptsDevice(*device);
+    }
+
     bool accepts = true;
     QModelIndex childIndex = sourceModel()->index(sourceRow, 0, sourceParent);
 
@@ -761,6 +1192,16 @@ bool DeviceFilter::filterAcceptsRow(int sourceRow,
 bool DeviceFilter::lessThan(const QModelIndex &left,
                             const QModelIndex &right) const
 {
+  if (m_deviceModel) {
+      const Device *a = m_deviceModel->deviceAt(left.row());
+      const Device *b = m_deviceModel->deviceAt(right.row());
+      if (a && b) {
+          // Raw names: the "…" of unpaired devices must not sort them.
+          const int order = a->compareName(*b);
+          return order != 0 ? order < 0 : a->getAddress() < b->getAddress();
+      }
+  }
+
   const QString a = sourceModel()->data(left, Qt::DisplayRole).value<QString>();
   const QString b = sourceModel()->data(right, Qt::DisplayRole).value<QString>();
   return a < b;
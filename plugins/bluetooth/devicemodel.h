@@ -29,7 +29,9 @@
 #include <QAbstractListModel>
 #include <QDBusConnection>
 #include <QDBusInterface>
+#include <QDBusMessage>
 #include <QScopedPointer>
+#include <QSettings>
 #include <QSharedPointer>
 #include <QSortFilterProxyModel>
 
@@ -57,7 +59,8 @@ public:
       ConnectionRole,
       AddressRole,
       TrustedRole,
-      LastRole = TrustedRole
+      StaleRole,
+      LastRole = StaleRole
     };
 
     // implemented virtual methods from QAbstractTableModel
@@ -68,6 +71,8 @@ public:
     QSharedPointer<Device> getDeviceFromAddress(const QString &address);
     QSharedPointer<Device> getDeviceFromPath(const QString &path);
     QSharedPointer<Device> addDeviceFromPath(const QDBusObjectPath &path);
+    /* Typed access for DeviceFilter, without going through data(). */
+    const Device *deviceAt(int row) const;
     QString adapterName() const { return m_adapterName; }
     QString adapterAddress() const { return m_adapterAddress; }
 
@@ -82,6 +87,10 @@ public:
     void toggleDiscovery();
     void blockDiscovery();
     void unblockDiscovery();
+    void setPageVisible(bool visible);
+    void setDiscoveryTransport(const QString &transport);
+    /* The gap before the next discovery window, grown by the backoff. */
+    int discoveryIdleDuration() const { return m_idleDuration; }
 
 Q_SIGNALS:
     void poweredChanged(bool powered);
@@ -111,7 +120,28 @@ private:
     unsigned int m_activeDevices;
     bool m_anyDeviceActive;
 
+    /* Discovery scheduling: idle gaps grow while discovery windows turn
+       up nothing new, and everything is shorter on battery. */
+    bool m_pageVisible = true;
+    bool m_onBattery = false;
+    bool m_foundDuringWindow = false;
+    int m_idleDuration;
+    QString m_discoveryTransport;
+    bool m_discoveryFilterSupported = true;
+
+    /* Paired and trusted devices are remembered between runs and shown,
+       marked stale, until BlueZ tells us about them. */
+    QSettings m_cache;
+    QTimer m_cacheTimer;
+    // Whether BlueZ listed the devices since the cache was loaded.
+    bool m_devicesListed = false;
+    void loadCachedDevices();
+    void dropStaleDevices();
+
     void restartDiscoveryTimer();
+    void resetDiscoveryBackoff();
+    void applyDiscoveryFilter();
+    void watchPowerSource();
     void setDiscoverable(bool discoverable);
     void setPowered(bool powered);
 
@@ -122,11 +152,32 @@ private:
     void setAdapterFromPath(const QString &objectPath, const QVariantMap &properties);
 
     QList<QSharedPointer<Device> > m_devices;
+    /* Indices into m_devices, kept current on insert and remove so that
+       lookups done for every BlueZ signal do not scan the list. */
+    struct DeviceIndex {
+        int row;
+        QString address; // as indexed in m_rowByAddress
+    };
+    QHash<const Device*, DeviceIndex> m_rowByDevice;
+    QHash<QString, int> m_rowByAddress;
+    QHash<QString, QSharedPointer<Device> > m_devicesByPath;
+    /* Roles changed since the last flush, one bit per role (see roleBit()),
+       so bursts of property changes become one dataChanged per row. */
+    QHash<const Device*, uint> m_changedRoles;
+    QTimer m_changeTimer;
+    void markChanged(const Device *device, int role);
+    void indexRow(int row);
+    void unindexRow(int row);
+    void clearDevices();
+
     void updateDevices();
+    void addDevices(const ManagedObjectList &objects);
     QSharedPointer<Device> addDevice(QSharedPointer<Device> &device);
     QSharedPointer<Device> addDevice(const QString &objectPath, const QVariantMap &properties);
+    QSharedPointer<Device> createDevice(const QString &objectPath, const QVariantMap &properties);
     void removeRow(int i);
     int findRowFromAddress(const QString &address) const;
+    int findRowFromDevice(const Device *device) const;
     void emitRowChanged(int row);
 
     void setDiscovering(bool value);
@@ -137,11 +188,18 @@ private Q_SLOTS:
     void slotInterfacesRemoved(const QDBusObjectPath &objectPath, const QStringList &interfaces);
     void slotAdapterPropertiesChanged(const QString &interface, const QVariantMap &changedProperties,
                                       const QStringList &invalidatedProperties);
+    void slotDevicePropertiesChanged(const QString &interface, const QVariantMap &changedProperties,
+                                     const QStringList &invalidatedProperties,
+                                     const QDBusMessage &message);
     void slotRemoveFinished(QDBusPendingCallWatcher *call);
     void slotPropertyChanged(const QString &key, const QDBusVariant &value);
     void slotDiscoveryTimeout();
     void slotEnableDiscoverable();
-    void slotDeviceChanged();
+    void slotFlushChanges();
+    void slotStoreCachedDevices();
+    void slotPowerSourceChanged(const QString &interface, const QVariantMap &changedProperties,
+                                const QStringList &invalidatedProperties);
+    void slotDeviceAddressChanged();
     void slotDevicePairingDone(bool success);
     void slotDeviceConnectionChanged();
 };
@@ -156,12 +214,17 @@ public:
     void filterOnType(const QVector<Device::Type>);
     void filterOnConnections(Device::Connections);
     void filterOnTrusted(bool trusted);
+    void setSourceModel(QAbstractItemModel *sourceModel) override;
 
 protected:
     virtual bool filterAcceptsRow(int, const QModelIndex&) const;
     virtual bool lessThan(const QModelIndex&, const QModelIndex&) const;
 
 private:
+    bool acceptsDevice(const Device &device) const;
+    void filterChanged();
+
+    DeviceModel *m_deviceModel = nullptr;
     QVector<Device::Type> m_types = QVector<Device::Type>();
     bool m_typeEnabled = false;
     Device::Connections m_connections = Device::Connection::Connected;
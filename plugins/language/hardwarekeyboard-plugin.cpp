@@ -20,6 +20,8 @@
  */
 
 #include <QDBusMetaType>
+#include <QDBusPendingCallWatcher>
+#include <QDBusPendingReply>
 #include <QtAlgorithms>
 #include <QtDebug>
 
@@ -31,28 +33,36 @@
 #define SOURCES_CONFIG_SCHEMA_ID "org.gnome.desktop.input-sources"
 #define SOURCES_KEY "sources"
 
-typedef QList<QMap<QString, QString>> StringMapList;
-Q_DECLARE_METATYPE(StringMapList)
+#define XKB_RULES_DIR "/usr/share/X11/xkb/rules"
+
+// Checking and reordering layouts in quick succession makes one write.
+#define INPUT_SOURCES_WRITE_DELAY 250
 
 HardwareKeyboardPlugin::HardwareKeyboardPlugin(QObject *parent) :
     QObject(parent),
-    m_sourcesSettings(g_settings_new(SOURCES_CONFIG_SCHEMA_ID))
+    m_keyboardLayouts("keyboard-layouts-xkb"),
+    m_sourcesSettings(g_settings_new(SOURCES_CONFIG_SCHEMA_ID)),
+    m_inputSourcesFetched(false),
+    m_inputSourcesRefreshing(false)
 {
     qDBusRegisterMetaType<StringMapList>();
-    m_xkbInfo = gnome_xkb_info_new();
 
+    m_inputSourcesTimer.setSingleShot(true);
+    m_inputSourcesTimer.setInterval(INPUT_SOURCES_WRITE_DELAY);
+    connect(&m_inputSourcesTimer, SIGNAL(timeout()),
+            SLOT(refreshInputSources()));
+
+    connect(&m_keyboardLayouts, SIGNAL(loaded()),
+            SLOT(updateKeyboardLayoutsModel()));
     updateKeyboardLayouts();
-    updateKeyboardLayoutsModel();
 }
 
 
 HardwareKeyboardPlugin::~HardwareKeyboardPlugin()
 {
-    if (m_xkbInfo != nullptr) {
-        g_object_unref(m_xkbInfo);
-    }
-
-    qDeleteAll(m_keyboardLayouts);
+    // Too late to read them back, the cached sources have to do.
+    if (m_inputSourcesTimer.isActive() || m_inputSourcesRefreshing)
+        writeInputSources();
 
     g_object_unref(m_sourcesSettings);
 }
@@ -66,21 +76,57 @@ HardwareKeyboardPlugin::keyboardLayoutsModel()
 void
 HardwareKeyboardPlugin::keyboardLayoutsModelChanged()
 {
-    QVariant answer = m_accountsService.getUserProperty(
+    m_inputSourcesTimer.start();
+}
+
+void
+HardwareKeyboardPlugin::refreshInputSources()
+{
+    // Other clients may have changed the ibus sources since we last read
+    // them, and writing back our copy would undo that.
+    QDBusPendingCall call = m_accountsService.getUserPropertyAsync(
                 "org.freedesktop.Accounts.User",
                 "InputSources");
-    StringMapList maps;
-    if (answer.isValid()) {
-        QDBusArgument arg = answer.value<QDBusArgument>();
-        maps = qdbus_cast<StringMapList>(arg);
+    QDBusPendingCallWatcher *watcher = new QDBusPendingCallWatcher(call, this);
+
+    connect(watcher, SIGNAL(finished(QDBusPendingCallWatcher *)),
+            SLOT(inputSourcesRefreshed(QDBusPendingCallWatcher *)));
+    m_inputSourcesRefreshing = true;
+}
+
+void
+HardwareKeyboardPlugin::inputSourcesRefreshed(QDBusPendingCallWatcher *call)
+{
+    QDBusPendingReply<QDBusVariant> answer = *call;
+    call->deleteLater();
+    m_inputSourcesRefreshing = false;
+
+    if (!answer.isValid()) {
+        qWarning() << "failed to refresh input sources:"
+                   << answer.error().message();
     } else {
+        QDBusArgument arg = answer.value().variant().value<QDBusArgument>();
+        m_inputSources = qdbus_cast<StringMapList>(arg);
+        m_inputSourcesFetched = true;
+    }
+
+    // A change made meanwhile restarted the timer and will write it all.
+    if (!m_inputSourcesTimer.isActive())
+        writeInputSources();
+}
+
+void
+HardwareKeyboardPlugin::writeInputSources()
+{
+    // Without them the ibus sources would be dropped.
+    if (!m_inputSourcesFetched) {
         qCritical() << "failed to get input sources";
         return;
     }
 
     StringMapList finalMaps;
-    for (int i = 0; i < maps.size(); i++) {
-        QMap<QString, QString> m = maps.at(i);
+    for (int i = 0; i < m_inputSources.size(); i++) {
+        const QMap<QString, QString> &m = m_inputSources.at(i);
 
         // Keep any maps not of xkb type (ibus e.g.)
         if (!m.contains(INPUT_SOURCE_TYPE_XKB)) {
@@ -96,12 +142,13 @@ HardwareKeyboardPlugin::keyboardLayoutsModelChanged()
     it.toBack();
     while (it.hasPrevious()) {
         QMap<QString, QString> m = QMap<QString, QString>();
-        KeyboardLayout* layout = m_keyboardLayouts.at(it.previous());
-        m.insert(INPUT_SOURCE_TYPE_XKB, layout->name());
+        const KeyboardLayout &layout(m_keyboardLayouts.layouts().at(it.previous()));
+        m.insert(INPUT_SOURCE_TYPE_XKB, layout.name());
         finalMaps.prepend(m);
     }
 
-    m_accountsService.customSetUserProperty(
+    m_inputSources = finalMaps;
+    m_accountsService.customSetUserPropertyAsync(
             "SetInputSources", QVariant::fromValue(finalMaps));
 
     // Save the config settings (for the keyboard indicator)
@@ -114,59 +161,49 @@ HardwareKeyboardPlugin::keyboardLayoutsModelChanged()
     g_settings_set_value(m_sourcesSettings, SOURCES_KEY, g_variant_builder_end(&builder));
 }
 
-static bool
-compareLayouts(const KeyboardLayout *layout0,
-               const KeyboardLayout *layout1)
-{
-    QString name0(layout0->displayName());
-    QString name1(layout1->displayName());
-
-    if (name0 == name1) {
-        name0 = layout0->language();
-        name1 = layout1->language();
-
-        if (name0 == name1) {
-            name0 = layout0->name();
-            name1 = layout1->name();
-        }
-    }
-
-    return QString::localeAwareCompare(name0, name1) < 0;
-}
-
-void
-HardwareKeyboardPlugin::updateKeyboardLayouts()
+static KeyboardLayoutList
+xkbLayouts()
 {
+    GnomeXkbInfo *xkbInfo(gnome_xkb_info_new());
     GList *sources, *tmp;
-    gchar *source_id = NULL;
     const gchar *display_name;
     const gchar *short_name;
     const gchar *xkb_layout;
     const gchar *xkb_variant;
-    sources = gnome_xkb_info_get_all_layouts(m_xkbInfo);
+    sources = gnome_xkb_info_get_all_layouts(xkbInfo);
 
-    m_keyboardLayouts.clear();
+    KeyboardLayoutList layouts;
+    layouts.reserve(g_list_length(sources));
 
     for (tmp = sources; tmp != NULL; tmp = tmp->next) {
-        g_free (source_id);
-        source_id = g_strconcat(INPUT_SOURCE_TYPE_XKB, tmp->data, NULL);
-
-        gnome_xkb_info_get_layout_info(m_xkbInfo, (const gchar *)tmp->data,
+        gnome_xkb_info_get_layout_info(xkbInfo, (const gchar *)tmp->data,
         &display_name, &short_name, &xkb_layout, &xkb_variant);
 
-        KeyboardLayout *layout(new KeyboardLayout((const gchar *)tmp->data,
-                                                  short_name,
-                                                  display_name,
-                                                  xkb_variant));
-        if (!layout->language().isEmpty())
-            m_keyboardLayouts += layout;
-        else
-            delete layout;
-
+        KeyboardLayout layout((const gchar *)tmp->data,
+                              short_name,
+                              display_name,
+                              xkb_variant);
+        if (!layout.language().isEmpty())
+            layouts += layout;
     }
-    g_free(source_id);
     g_list_free(sources);
-    qSort(m_keyboardLayouts.begin(), m_keyboardLayouts.end(), compareLayouts);
+    g_object_unref(xkbInfo);
+
+    return layouts;
+}
+
+void
+HardwareKeyboardPlugin::updateKeyboardLayouts()
+{
+    // The layouts only change with the xkb rules, and their names and
+    // order with the language they are shown in.
+    QString key(QLocale::system().name());
+    Q_FOREACH(const QString &rules, QStringList() << "evdev.xml" << "evdev.extras.xml") {
+        QFileInfo fileInfo(QDir(XKB_RULES_DIR), rules);
+        key += QString(":%1").arg(fileInfo.lastModified().toMSecsSinceEpoch());
+    }
+
+    m_keyboardLayouts.load(key, xkbLayouts);
 }
 
 void
@@ -179,54 +216,72 @@ HardwareKeyboardPlugin::updateKeyboardLayoutsModel()
     m_keyboardLayoutsModel.setCustomRoles(customRoles);
 
     QVariantList superset;
+    superset.reserve(m_keyboardLayouts.layouts().size());
 
-    for (QList<KeyboardLayout *>::const_iterator
-         i(m_keyboardLayouts.begin()); i != m_keyboardLayouts.end(); ++i) {
+    Q_FOREACH(const KeyboardLayout &layout, m_keyboardLayouts.layouts()) {
         QVariantList element;
 
-        if (!(*i)->displayName().isEmpty())
-            element += (*i)->displayName();
+        if (!layout.displayName().isEmpty())
+            element += layout.displayName();
         else
-            element += (*i)->name();
+            element += layout.name();
 
-        element += (*i)->shortName();
+        element += layout.shortName();
         superset += QVariant(element);
     }
 
     m_keyboardLayoutsModel.setSuperset(superset);
 
     enabledLayoutsChanged();
-
-    connect(&m_keyboardLayoutsModel,
-            SIGNAL(subsetChanged()),
-            SLOT(keyboardLayoutsModelChanged()));
 }
 
 void
 HardwareKeyboardPlugin::enabledLayoutsChanged()
 {
-    QList<int> subset;
-
-    QVariant answer = m_accountsService.getUserProperty(
+    QDBusPendingCall call = m_accountsService.getUserPropertyAsync(
                 "org.freedesktop.Accounts.User",
                 "InputSources");
+    QDBusPendingCallWatcher *watcher = new QDBusPendingCallWatcher(call, this);
 
-    if (answer.isValid()) {
-        QDBusArgument arg = answer.value<QDBusArgument>();
-        StringMapList list = qdbus_cast<StringMapList>(arg);
+    connect(watcher, SIGNAL(finished(QDBusPendingCallWatcher *)),
+            SLOT(inputSourcesFetched(QDBusPendingCallWatcher *)));
+}
+
+void
+HardwareKeyboardPlugin::inputSourcesFetched(QDBusPendingCallWatcher *call)
+{
+    QDBusPendingReply<QDBusVariant> answer = *call;
+    call->deleteLater();
+
+    if (!answer.isValid()) {
+        qCritical() << "failed to get input sources";
+    } else {
+        QDBusArgument arg = answer.value().variant().value<QDBusArgument>();
+        m_inputSources = qdbus_cast<StringMapList>(arg);
+        m_inputSourcesFetched = true;
+
+        // Our own write is still to come and would be undone.
+        if (!m_inputSourcesTimer.isActive()) {
+            QList<int> subset;
 
-        for (int i = 0; i < list.length(); ++i) {
-            for (int j = 0; j < m_keyboardLayouts.length(); j++) {
-                if (m_keyboardLayouts[j]->name() == list.at(i)[INPUT_SOURCE_TYPE_XKB]) {
-                    subset += j;
-                    break;
-                }
+            for (int i = 0; i < m_inputSources.length(); ++i) {
+                int index(m_keyboardLayouts.indexOf(
+                              m_inputSources.at(i)[INPUT_SOURCE_TYPE_XKB]));
+
+                if (index >= 0)
+                    subset += index;
             }
+
+            m_keyboardLayoutsModel.setSubset(subset);
         }
-        m_keyboardLayoutsModel.setSubset(subset);
-    } else {
-        qCritical() << "failed to get input sources";
     }
+
+    // Only what the user changes from now on is written back, not the
+    // subset we have just loaded.
+    connect(&m_keyboardLayoutsModel,
+            SIGNAL(subsetChanged()),
+            SLOT(keyboardLayoutsModelChanged()),
+            Qt::UniqueConnection);
 }
 
 void HardwareKeyboardPlugin::setCurrentLayout(const QString &code)
@@ -37,7 +37,11 @@ typedef void *gpointer;
 typedef char gchar;
 typedef struct _GSettings GSettings;
 
+typedef QList<QMap<QString, QString>> StringMapList;
+Q_DECLARE_METATYPE(StringMapList)
+
 class KeyboardLayout;
+class QDBusPendingCallWatcher;
 
 class HardwareKeyboardPlugin : public QObject
 {
@@ -65,13 +69,21 @@ public:
 private:
     void updateEnabledLayouts();
     void updateKeyboardLayouts();
-    void updateKeyboardLayoutsModel();
+    Q_SLOT void updateKeyboardLayoutsModel();
+    Q_SLOT void inputSourcesFetched(QDBusPendingCallWatcher *call);
+    Q_SLOT void refreshInputSources();
+    Q_SLOT void inputSourcesRefreshed(QDBusPendingCallWatcher *call);
+    void writeInputSources();
 
-    GnomeXkbInfo *m_xkbInfo;
-    QList<KeyboardLayout *> m_keyboardLayouts;
+    KeyboardLayoutTable m_keyboardLayouts;
     SubsetModel m_keyboardLayoutsModel;
     AccountsService m_accountsService;
     GSettings *m_sourcesSettings;
+    // Last InputSources known to AccountsService, ibus sources included.
+    StringMapList m_inputSources;
+    bool m_inputSourcesFetched;
+    bool m_inputSourcesRefreshing;
+    QTimer m_inputSourcesTimer;
 };
 
 #endif // HWKBD_PLUGIN_H
@@ -19,26 +19,68 @@
  */
 
 #include "keyboard-layout.h"
+#include <QCollator>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QtConcurrent>
+#include <QtDebug>
+#include <algorithm>
+#include <numeric>
+#include <vector>
 #include <unicode/locid.h>
 
+namespace
+{
+    const quint32 TABLE_VERSION = 1;
+
+    KeyboardLayoutList buildSorted(const KeyboardLayoutTable::Builder &build)
+    {
+        const KeyboardLayoutList layouts(build());
+        const QCollator collator;
+
+        // Collate each display name once, up front. Languages and names
+        // only break ties, so they are compared as they come.
+        std::vector<QCollatorSortKey> keys;
+        keys.reserve(layouts.size());
+        Q_FOREACH(const KeyboardLayout &layout, layouts)
+            keys.push_back(collator.sortKey(layout.displayName()));
+
+        std::vector<int> order(layouts.size());
+        std::iota(order.begin(), order.end(), 0);
+        std::sort(order.begin(), order.end(), [&](int i, int j) {
+            int result = keys[i].compare(keys[j]);
+            if (result == 0)
+                result = collator.compare(layouts[i].language(),
+                                          layouts[j].language());
+            if (result == 0)
+                result = collator.compare(layouts[i].name(),
+                                          layouts[j].name());
+            return result < 0;
+        });
+
+        KeyboardLayoutList sorted;
+        sorted.reserve(layouts.size());
+        for (int i : order)
+            sorted += layouts[i];
+        return sorted;
+    }
+}
+
 KeyboardLayout::KeyboardLayout(const QString &name,
                                const QString &language,
                                const QString &displayName,
-                               const QString &shortName,
-                               QObject       *parent) :
-    QObject(parent),
+                               const QString &shortName) :
     m_name(name),
     m_language(language),
     m_displayName(displayName),
     m_shortName(language)
 {
     Q_UNUSED(shortName);
-    m_shortName[0] = m_shortName[0].toUpper();
+    if (!m_shortName.isEmpty())
+        m_shortName[0] = m_shortName[0].toUpper();
 }
 
-KeyboardLayout::KeyboardLayout(const QFileInfo &fileInfo,
-                               QObject         *parent) :
-    QObject(parent),
+KeyboardLayout::KeyboardLayout(const QFileInfo &fileInfo) :
     m_name(fileInfo.fileName())
 {
     icu::Locale locale(qPrintable(m_name));
@@ -51,7 +93,8 @@ KeyboardLayout::KeyboardLayout(const QFileInfo &fileInfo,
     m_language = locale.getLanguage();
     m_displayName = string.c_str();
     m_shortName = m_language.left(2);
-    m_shortName[0] = m_shortName[0].toUpper();
+    if (!m_shortName.isEmpty())
+        m_shortName[0] = m_shortName[0].toUpper();
 }
 
 const QString &
@@ -77,3 +120,119 @@ KeyboardLayout::shortName() const
 {
     return m_shortName;
 }
+
+QDataStream &
+operator<<(QDataStream &out, const KeyboardLayout &layout)
+{
+    return out << layout.m_name << layout.m_language
+               << layout.m_displayName << layout.m_shortName;
+}
+
+QDataStream &
+operator>>(QDataStream &in, KeyboardLayout &layout)
+{
+    return in >> layout.m_name >> layout.m_language
+              >> layout.m_displayName >> layout.m_shortName;
+}
+
+KeyboardLayoutTable::KeyboardLayoutTable(const QString &cacheName,
+                                         QObject       *parent) :
+    QObject(parent),
+    m_cachePath(QStandardPaths::writableLocation(QStandardPaths::CacheLocation)
+                + "/" + cacheName)
+{
+    connect(&m_build, SIGNAL(finished()), this, SLOT(buildFinished()));
+}
+
+KeyboardLayoutTable::~KeyboardLayoutTable()
+{
+    m_build.waitForFinished();
+}
+
+void
+KeyboardLayoutTable::load(const QString &key, const Builder &build)
+{
+    m_key = key;
+
+    if (readCache()) {
+        indexLayouts();
+        Q_EMIT loaded();
+        return;
+    }
+
+    m_build.setFuture(QtConcurrent::run(buildSorted, build));
+}
+
+const KeyboardLayoutList &
+KeyboardLayoutTable::layouts() const
+{
+    return m_layouts;
+}
+
+int
+KeyboardLayoutTable::indexOf(const QString &name) const
+{
+    return m_indices.value(name, -1);
+}
+
+void
+KeyboardLayoutTable::buildFinished()
+{
+    m_layouts = m_build.result();
+    writeCache();
+    indexLayouts();
+    Q_EMIT loaded();
+}
+
+bool
+KeyboardLayoutTable::readCache()
+{
+    QFile file(m_cachePath);
+    if (!file.open(QIODevice::ReadOnly))
+        return false;
+
+    QDataStream in(&file);
+    quint32 version;
+    QString storedKey;
+    in >> version;
+    if (version != TABLE_VERSION)
+        return false;
+    in >> storedKey;
+    if (storedKey != m_key)
+        return false;
+
+    KeyboardLayoutList layouts;
+    in >> layouts;
+
+    if (in.status() != QDataStream::Ok)
+        return false;
+
+    m_layouts = layouts;
+    return true;
+}
+
+void
+KeyboardLayoutTable::writeCache() const
+{
+    QDir().mkpath(QFileInfo(m_cachePath).absolutePath());
+
+    QSaveFile file(m_cachePath);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning() << "Cannot write keyboard layouts to" << m_cachePath;
+        return;
+    }
+
+    QDataStream out(&file);
+    out << TABLE_VERSION << m_key << m_layouts;
+    file.commit();
+}
+
+void
+KeyboardLayoutTable::indexLayouts()
+{
+    m_indices.clear();
+    m_indices.reserve(m_layouts.size());
+
+    for (int i = 0; i < m_layouts.size(); i++)
+        m_indices.insert(m_layouts[i].name(), i);
+}
@@ -22,35 +22,19 @@
 #define KEYBOARD_LAYOUT_H
 
 #include <QtCore>
+#include <QFutureWatcher>
+#include <functional>
 
-class KeyboardLayout : public QObject
+class KeyboardLayout
 {
-private:
-
-    Q_OBJECT
-
-    Q_PROPERTY(QString name
-               READ name
-               CONSTANT)
-
-    Q_PROPERTY(QString language
-               READ language
-               CONSTANT)
-
-    Q_PROPERTY(QString displayName
-               READ displayName
-               CONSTANT)
-
 public:
 
     explicit KeyboardLayout(const QString &name        = QString(),
                             const QString &language    = QString(),
                             const QString &displayName = QString(),
-                            const QString &shortName   = QString(),
-                            QObject       *parent      = nullptr);
+                            const QString &shortName   = QString());
 
-    explicit KeyboardLayout(const QFileInfo &fileInfo,
-                            QObject         *parent   = nullptr);
+    explicit KeyboardLayout(const QFileInfo &fileInfo);
 
     const QString &name() const;
     const QString &language() const;
@@ -59,10 +43,65 @@ public:
 
 private:
 
+    friend QDataStream &operator<<(QDataStream &out, const KeyboardLayout &layout);
+    friend QDataStream &operator>>(QDataStream &in, KeyboardLayout &layout);
+
     QString m_name;
     QString m_language;
     QString m_displayName;
     QString m_shortName;
 };
 
+Q_DECLARE_TYPEINFO(KeyboardLayout, Q_MOVABLE_TYPE);
+
+typedef QVector<KeyboardLayout> KeyboardLayoutList;
+
+/*
+ * Keyboard layouts sorted by display name. The table is read back from
+ * a cache file while the key it was stored under still matches, and is
+ * otherwise built and sorted on a worker thread.
+ */
+class KeyboardLayoutTable : public QObject
+{
+private:
+
+    Q_OBJECT
+
+public:
+
+    typedef std::function<KeyboardLayoutList()> Builder;
+
+    explicit KeyboardLayoutTable(const QString &cacheName,
+                                 QObject       *parent = nullptr);
+
+    virtual ~KeyboardLayoutTable();
+
+    // Emits loaded() before returning when the cache is current.
+    void load(const QString &key, const Builder &build);
+
+    const KeyboardLayoutList &layouts() const;
+    // Position of the layout called name, or -1.
+    int indexOf(const QString &name) const;
+
+Q_SIGNALS:
+
+    void loaded();
+
+private Q_SLOTS:
+
+    void buildFinished();
+
+private:
+
+    bool readCache();
+    void writeCache() const;
+    void indexLayouts();
+
+    QString m_cachePath;
+    QString m_key;
+    KeyboardLayoutList m_layouts;
+    QHash<QString, int> m_indices;
+    QFutureWatcher<KeyboardLayoutList> m_build;
+};
+
 #endif // KEYBOARD_LAYOUT_H
@@ -17,6 +17,8 @@
  * You should have received a copy of the GNU General Public License along
  * with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
+#include <QCollator>
+#include <QSaveFile>
 #include <QStandardPaths>
 #include <QtDebug>
 #include "language-plugin.h"
@@ -36,27 +38,44 @@ public:
     QString localeName;
     QString displayName;
     icu::Locale locale;
+    // Collation key of displayName, computed once rather than per comparison.
+    QCollatorSortKey sortKey;
 
 public:
 
-    explicit LanguageLocale(const QString &name);
+    LanguageLocale(const QString &name, const QCollator &collator);
 
     bool operator<(const LanguageLocale &l) const;
 };
 
-LanguageLocale::LanguageLocale(const QString &name) :
+namespace
+{
+    /* Bump when the catalog layout or the way it is built changes. */
+    const quint32 CATALOG_VERSION = 1;
+
+    QString displayNameOf(const icu::Locale &locale)
+    {
+        std::string string;
+        icu::UnicodeString unicodeString;
+        locale.getDisplayName(locale, unicodeString);
+        unicodeString.toUTF8String(string);
+        QString displayName(string.c_str());
+        /* workaround iso-codes casing being inconsistant */
+        if (displayName.length() > 0)
+            displayName[0] = displayName[0].toUpper();
+        return displayName;
+    }
+}
+
+LanguageLocale::LanguageLocale(const QString &name, const QCollator &collator) :
     likely(false),
     localeName(name),
-    locale(qPrintable(name))
+    displayName(),
+    locale(qPrintable(name)),
+    sortKey(collator.sortKey(QString()))
 {
-    std::string string;
-    icu::UnicodeString unicodeString;
-    locale.getDisplayName(locale, unicodeString);
-    unicodeString.toUTF8String(string);
-    displayName = string.c_str();
-    /* workaround iso-codes casing being inconsistant */
-    if (displayName.length() > 0)
-        displayName[0] = displayName[0].toUpper();
+    displayName = displayNameOf(locale);
+    sortKey = collator.sortKey(displayName);
 }
 
 bool LanguageLocale::operator<(const LanguageLocale &l) const
@@ -67,7 +86,7 @@ bool LanguageLocale::operator<(const LanguageLocale &l) const
             return likely && !l.likely;
     }
 
-    return QString::localeAwareCompare(displayName, l.displayName) < 0;
+    return sortKey.compare(l.sortKey) < 0;
 }
 
 void managerLoaded(GObject    *object,
@@ -167,6 +186,20 @@ LanguagePlugin::updateLanguageNamesAndCodes()
         return;
     }
 
+    // The catalog only changes when language packs come or go, which
+    // touches the directory, or when the names are to be shown in
+    // another language.
+    const QString catalogPath =
+        QStandardPaths::writableLocation(QStandardPaths::CacheLocation)
+        + "/language-catalog";
+    const QString catalogKey = QString("%1:%2:%3")
+        .arg(langpackDir.absolutePath())
+        .arg(QFileInfo(langpackDir.absolutePath()).lastModified().toMSecsSinceEpoch())
+        .arg(QLocale::system().name());
+
+    if (loadLanguageCatalog(catalogPath, catalogKey))
+        return;
+
     const QStringList langpackNames = langpackDir.entryList(QDir::Dirs | QDir::NoDotAndDotDot | QDir::Readable);
 
     QStringList tmpLocales;
@@ -177,9 +210,10 @@ LanguagePlugin::updateLanguageNamesAndCodes()
 
     QSet<QString> localeNames = tmpLocales.toSet();
     QList<LanguageLocale> languageLocales;
+    QCollator collator;
 
     Q_FOREACH(const QString &loc, localeNames) {
-        LanguageLocale languageLocale(loc);
+        LanguageLocale languageLocale(loc, collator);
 
         // Filter out locales for which we have no display name.
         if (languageLocale.displayName.isEmpty())
@@ -209,6 +243,56 @@ LanguagePlugin::updateLanguageNamesAndCodes()
             m_indicesByLocale.insert(localeName, i);
         }
     }
+
+    storeLanguageCatalog(catalogPath, catalogKey);
+}
+
+bool
+LanguagePlugin::loadLanguageCatalog(const QString &path, const QString &key)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly))
+        return false;
+
+    QDataStream in(&file);
+    quint32 version;
+    QString storedKey;
+    in >> version;
+    if (version != CATALOG_VERSION)
+        return false;
+    in >> storedKey;
+    if (storedKey != key)
+        return false;
+
+    QStringList names;
+    QStringList codes;
+    QHash<QString, unsigned int> indices;
+    in >> names >> codes >> indices;
+
+    if (in.status() != QDataStream::Ok || names.size() != codes.size())
+        return false;
+
+    m_languageNames = names;
+    m_languageCodes = codes;
+    m_indicesByLocale = indices;
+    return true;
+}
+
+void
+LanguagePlugin::storeLanguageCatalog(const QString &path, const QString &key) const
+{
+    QDir().mkpath(QFileInfo(path).absolutePath());
+
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning() << "Cannot write language catalog to" << path;
+        return;
+    }
+
+    QDataStream out(&file);
+    out << CATALOG_VERSION << key
+        << m_languageNames << m_languageCodes << m_indicesByLocale;
+    file.commit();
 }
 
 void
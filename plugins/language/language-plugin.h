@@ -79,6 +79,8 @@ public:
 private:
 
     void updateLanguageNamesAndCodes();
+    bool loadLanguageCatalog(const QString &path, const QString &key);
+    void storeLanguageCatalog(const QString &path, const QString &key) const;
     void updateCurrentLanguage();
     void updateSpellCheckingModel();
 
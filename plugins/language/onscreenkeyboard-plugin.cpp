@@ -33,7 +33,8 @@
 
 OnScreenKeyboardPlugin::OnScreenKeyboardPlugin(QObject *parent) :
     QObject(parent),
-    m_maliitSettings(g_settings_new(UBUNTU_KEYBOARD_SCHEMA_ID))
+    m_maliitSettings(g_settings_new(UBUNTU_KEYBOARD_SCHEMA_ID)),
+    m_keyboardLayouts("keyboard-layouts-osk")
 {
     GVariantIter *iter;
     const gchar *path;
@@ -51,8 +52,10 @@ OnScreenKeyboardPlugin::OnScreenKeyboardPlugin(QObject *parent) :
         m_layoutPaths.append(path);
     }
     updateEnabledLayouts();
+
+    connect(&m_keyboardLayouts, SIGNAL(loaded()),
+            SLOT(updateKeyboardLayoutsModel()));
     updateKeyboardLayouts();
-    updateKeyboardLayoutsModel();
 }
 
 
@@ -62,10 +65,6 @@ OnScreenKeyboardPlugin::~OnScreenKeyboardPlugin()
         g_signal_handlers_disconnect_by_data(m_maliitSettings, this);
         g_object_unref(m_maliitSettings);
     }
-
-    for (QList<KeyboardLayout *>::const_iterator
-         i(m_keyboardLayouts.begin()); i != m_keyboardLayouts.end(); ++i)
-        delete *i;
 }
 
 SubsetModel *
@@ -81,6 +80,8 @@ OnScreenKeyboardPlugin::keyboardLayoutsModelChanged()
     gchar *current;
     bool removed(true);
 
+    const KeyboardLayoutList &layouts(m_keyboardLayouts.layouts());
+
     g_variant_builder_init(&builder, G_VARIANT_TYPE("as"));
     g_settings_get(m_maliitSettings, KEY_CURRENT_LAYOUT, "s", &current);
 
@@ -88,9 +89,9 @@ OnScreenKeyboardPlugin::keyboardLayoutsModelChanged()
          i(m_keyboardLayoutsModel.subset().begin());
          i != m_keyboardLayoutsModel.subset().end(); ++i) {
         g_variant_builder_add(&builder, "s",
-                              qPrintable(m_keyboardLayouts[*i]->name()));
+                              qPrintable(layouts[*i].name()));
 
-        if (m_keyboardLayouts[*i]->name() == current)
+        if (layouts[*i].name() == current)
             removed = false;
     }
 
@@ -109,7 +110,7 @@ OnScreenKeyboardPlugin::keyboardLayoutsModelChanged()
                     i = m_keyboardLayoutsModel.subset().size() - 1;
 
                 int index(m_keyboardLayoutsModel.subset()[i]);
-                const QString &name(m_keyboardLayouts[index]->name());
+                const QString &name(layouts[index].name());
 
                 g_settings_set_string(m_maliitSettings,
                                       KEY_CURRENT_LAYOUT, qPrintable(name));
@@ -120,7 +121,7 @@ OnScreenKeyboardPlugin::keyboardLayoutsModelChanged()
 
         if (!found) {
             int index(m_keyboardLayoutsModel.subset().front());
-            const QString &name(m_keyboardLayouts[index]->name());
+            const QString &name(layouts[index].name());
 
             g_settings_set_string(m_maliitSettings,
                                   KEY_CURRENT_LAYOUT, qPrintable(name));
@@ -134,26 +135,6 @@ OnScreenKeyboardPlugin::keyboardLayoutsModelChanged()
                          KEY_ENABLED_LAYOUTS, g_variant_builder_end(&builder));
 }
 
-static bool
-compareLayouts(const KeyboardLayout *layout0,
-               const KeyboardLayout *layout1)
-{
-    QString name0(layout0->displayName());
-    QString name1(layout1->displayName());
-
-    if (name0 == name1) {
-        name0 = layout0->language();
-        name1 = layout1->language();
-
-        if (name0 == name1) {
-            name0 = layout0->name();
-            name1 = layout1->name();
-        }
-    }
-
-    return QString::localeAwareCompare(name0, name1) < 0;
-}
-
 void
 OnScreenKeyboardPlugin::updateEnabledLayouts()
 {
@@ -185,13 +166,13 @@ OnScreenKeyboardPlugin::updateEnabledLayouts()
                          KEY_ENABLED_LAYOUTS, g_variant_builder_end(&builder));
 }
 
-void
-OnScreenKeyboardPlugin::updateKeyboardLayouts()
+static KeyboardLayoutList
+layoutsIn(const QStringList &layoutPaths)
 {
-    m_keyboardLayouts.clear();
+    KeyboardLayoutList layouts;
 
-    for (int i = 0; i < m_layoutPaths.count(); i++) {
-        QDir layoutsDir(m_layoutPaths.at(i));
+    for (int i = 0; i < layoutPaths.count(); i++) {
+        QDir layoutsDir(layoutPaths.at(i));
         layoutsDir.setFilter(QDir::Dirs);
         layoutsDir.setSorting(QDir::Name);
 
@@ -199,16 +180,31 @@ OnScreenKeyboardPlugin::updateKeyboardLayouts()
 
         for (QFileInfoList::const_iterator
              i(fileInfoList.begin()); i != fileInfoList.end(); ++i) {
-            KeyboardLayout *layout(new KeyboardLayout(*i));
+            KeyboardLayout layout(*i);
 
-            if (!layout->language().isEmpty())
-                m_keyboardLayouts += layout;
-            else
-                delete layout;
+            if (!layout.language().isEmpty())
+                layouts += layout;
         }
     }
 
-    qSort(m_keyboardLayouts.begin(), m_keyboardLayouts.end(), compareLayouts);
+    return layouts;
+}
+
+void
+OnScreenKeyboardPlugin::updateKeyboardLayouts()
+{
+    // Adding or removing a layout touches its directory; the order
+    // depends on the language the layouts are sorted in.
+    QString key(QLocale::system().name());
+    Q_FOREACH(const QString &path, m_layoutPaths) {
+        key += QString(":%1:%2").arg(path)
+            .arg(QFileInfo(path).lastModified().toMSecsSinceEpoch());
+    }
+
+    const QStringList layoutPaths(m_layoutPaths);
+    m_keyboardLayouts.load(key, [layoutPaths]() {
+        return layoutsIn(layoutPaths);
+    });
 }
 
 void enabledLayoutsChanged(GSettings *settings,
@@ -225,17 +221,17 @@ OnScreenKeyboardPlugin::updateKeyboardLayoutsModel()
     m_keyboardLayoutsModel.setCustomRoles(customRoles);
 
     QVariantList superset;
+    superset.reserve(m_keyboardLayouts.layouts().size());
 
-    for (QList<KeyboardLayout *>::const_iterator
-         i(m_keyboardLayouts.begin()); i != m_keyboardLayouts.end(); ++i) {
+    Q_FOREACH(const KeyboardLayout &layout, m_keyboardLayouts.layouts()) {
         QVariantList element;
 
-        if (!(*i)->displayName().isEmpty())
-            element += (*i)->displayName();
+        if (!layout.displayName().isEmpty())
+            element += layout.displayName();
         else
-            element += (*i)->name();
+            element += layout.name();
 
-        element += (*i)->shortName();
+        element += layout.shortName();
         superset += QVariant(element);
     }
 
@@ -262,12 +258,10 @@ OnScreenKeyboardPlugin::enabledLayoutsChanged()
     g_settings_get(m_maliitSettings, KEY_ENABLED_LAYOUTS, "as", &iter);
 
     while (g_variant_iter_next(iter, "&s", &layout)) {
-        for (int i(0); i < m_keyboardLayouts.length(); i++) {
-            if (m_keyboardLayouts[i]->name() == layout) {
-                subset += i;
-                break;
-            }
-        }
+        int index(m_keyboardLayouts.indexOf(layout));
+
+        if (index >= 0)
+            subset += index;
     }
 
     g_variant_iter_free(iter);
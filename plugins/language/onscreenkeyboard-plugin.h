@@ -58,7 +58,7 @@ private:
 
     void updateEnabledLayouts();
     void updateKeyboardLayouts();
-    void updateKeyboardLayoutsModel();
+    Q_SLOT void updateKeyboardLayoutsModel();
 
     void enabledLayoutsChanged();
 
@@ -67,7 +67,7 @@ private:
                                       gpointer   user_data);
 
     GSettings *m_maliitSettings;
-    QList<KeyboardLayout *> m_keyboardLayouts;
+    KeyboardLayoutTable m_keyboardLayouts;
     SubsetModel m_keyboardLayoutsModel;
     QStringList m_layoutPaths;
 };
@@ -23,6 +23,7 @@
 
 #include <QtQml>
 #include "subset-model.h"
+#include "subset-filter-model.h"
 #include "language-plugin.h"
 #include "onscreenkeyboard-plugin.h"
 #include "hardwarekeyboard-plugin.h"
@@ -32,6 +33,7 @@ void BackendPlugin::registerTypes(const char *uri)
     Q_ASSERT(uri == QLatin1String("Ubuntu.SystemSettings.LanguagePlugin"));
 
     qmlRegisterType<SubsetModel>(uri, 1, 0, "SubsetModel");
+    qmlRegisterType<SubsetFilterModel>(uri, 1, 0, "SubsetFilterModel");
     qmlRegisterType<LanguagePlugin>(uri, 1, 0, "UbuntuLanguagePlugin");
     qmlRegisterType<OnScreenKeyboardPlugin>(uri, 1, 0, "OnScreenKeyboardPlugin");
     qmlRegisterType<HardwareKeyboardPlugin>(uri, 1, 0, "HardwareKeyboardPlugin");
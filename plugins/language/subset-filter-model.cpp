@@ -0,0 +1,201 @@
+/*
+ * This file is part of system-settings
+ *
+ * Copyright (C) 2016 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3, as published
+ * by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranties of
+ * MERCHANTABILITY, SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "subset-filter-model.h"
+
+namespace
+{
+    // Lower case without accents, so that "Ü" and "u" compare equal.
+    QString fold(const QString &text)
+    {
+        const QString decomposed(text.normalized(QString::NormalizationForm_KD));
+        QString folded;
+        folded.reserve(decomposed.length());
+
+        Q_FOREACH(const QChar &c, decomposed) {
+            if (c.category() != QChar::Mark_NonSpacing)
+                folded += c;
+        }
+
+        return folded.toCaseFolded();
+    }
+
+    QStringList words(const QString &folded)
+    {
+        QStringList words;
+        int start(-1);
+
+        for (int i(0); i <= folded.length(); i++) {
+            bool inWord(i < folded.length() && folded[i].isLetterOrNumber());
+
+            if (inWord && start < 0) {
+                start = i;
+            } else if (!inWord && start >= 0) {
+                words += folded.mid(start, i - start);
+                start = -1;
+            }
+        }
+
+        return words;
+    }
+}
+
+SubsetFilterModel::SubsetFilterModel(QObject *parent) :
+    QSortFilterProxyModel(parent)
+{
+}
+
+SubsetModel *
+SubsetFilterModel::model() const
+{
+    return m_model;
+}
+
+void
+SubsetFilterModel::setModel(SubsetModel *model)
+{
+    if (model != m_model)
+        setSourceModel(model);
+}
+
+void
+SubsetFilterModel::setSourceModel(QAbstractItemModel *sourceModel)
+{
+    if (m_model != nullptr)
+        disconnect(m_model, SIGNAL(modelReset()), this, SLOT(sourceReset()));
+
+    m_model = qobject_cast<SubsetModel *>(sourceModel);
+
+    // Ahead of the proxy's own handler, which filters the new rows.
+    if (m_model != nullptr)
+        connect(m_model, SIGNAL(modelReset()), SLOT(sourceReset()));
+
+    indexSuperset();
+    QSortFilterProxyModel::setSourceModel(sourceModel);
+
+    Q_EMIT modelChanged();
+}
+
+const QString &
+SubsetFilterModel::filter() const
+{
+    return m_filter;
+}
+
+void
+SubsetFilterModel::setFilter(const QString &filter)
+{
+    if (filter != m_filter) {
+        QString folded(fold(filter));
+        bool narrower(folded.startsWith(m_foldedFilter));
+
+        m_filter = filter;
+        m_foldedFilter = folded;
+        m_filterWords = words(folded);
+
+        updateMatches(narrower);
+        invalidateFilter();
+
+        Q_EMIT filterChanged();
+    }
+}
+
+int
+SubsetFilterModel::elementAtRow(int row) const
+{
+    if (m_model == nullptr)
+        return -1;
+
+    const QList<int> &subset(m_model->subset());
+    int sourceRow(mapToSource(index(row, 0)).row());
+
+    if (sourceRow < 0)
+        return -1;
+
+    return sourceRow < subset.length() ? subset[sourceRow] : sourceRow - subset.length();
+}
+
+bool
+SubsetFilterModel::filterAcceptsRow(int                sourceRow,
+                                    const QModelIndex &sourceParent) const
+{
+    Q_UNUSED(sourceParent);
+
+    if (m_model == nullptr || m_filterWords.isEmpty())
+        return true;
+
+    const QList<int> &subset(m_model->subset());
+    int element(sourceRow < subset.length() ? subset[sourceRow] : sourceRow - subset.length());
+
+    return element < m_matches.size() && m_matches.testBit(element);
+}
+
+void
+SubsetFilterModel::sourceReset()
+{
+    // Also reset when only the subset changed, which leaves the words be.
+    if (m_model->superset() != m_superset)
+        indexSuperset();
+}
+
+void
+SubsetFilterModel::indexSuperset()
+{
+    m_superset = m_model != nullptr ? m_model->superset() : QVariantList();
+    m_words.clear();
+    m_words.reserve(m_superset.length());
+
+    Q_FOREACH(const QVariant &element, m_superset)
+        m_words += words(fold(element.toList().value(0).toString()));
+
+    updateMatches(false);
+}
+
+bool
+SubsetFilterModel::matches(int element) const
+{
+    const QStringList &elementWords(m_words[element]);
+
+    Q_FOREACH(const QString &filterWord, m_filterWords) {
+        bool found(false);
+
+        Q_FOREACH(const QString &word, elementWords) {
+            if (word.startsWith(filterWord)) {
+                found = true;
+                break;
+            }
+        }
+
+        if (!found)
+            return false;
+    }
+
+    return true;
+}
+
+void
+SubsetFilterModel::updateMatches(bool narrower)
+{
+    if (!narrower || m_matches.size() != m_words.size())
+        m_matches.fill(true, m_words.size());
+
+    for (int i(0); i < m_matches.size(); i++) {
+        if (m_matches.testBit(i) && !matches(i))
+            m_matches.clearBit(i);
+    }
+}
@@ -0,0 +1,88 @@
+/*
+ * This file is part of system-settings
+ *
+ * Copyright (C) 2016 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3, as published
+ * by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranties of
+ * MERCHANTABILITY, SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SUBSET_FILTER_MODEL_H
+#define SUBSET_FILTER_MODEL_H
+
+#include <QtCore>
+#include "subset-model.h"
+
+/*
+ * Rows of a SubsetModel whose display text matches a filter. Every
+ * word of the filter must start a word of the display text, ignoring
+ * case and accents. The display texts are folded and split into words
+ * once per superset, and a filter that extends the previous one is
+ * only tried on the elements that matched before.
+ */
+class SubsetFilterModel : public QSortFilterProxyModel
+{
+private:
+
+    Q_OBJECT
+
+public:
+
+    Q_PROPERTY(SubsetModel *model
+               READ model
+               WRITE setModel
+               NOTIFY modelChanged)
+
+    Q_PROPERTY(QString filter
+               READ filter
+               WRITE setFilter
+               NOTIFY filterChanged)
+
+    explicit SubsetFilterModel(QObject *parent = nullptr);
+
+    SubsetModel *model() const;
+    void setModel(SubsetModel *model);
+    Q_SIGNAL void modelChanged() const;
+
+    const QString &filter() const;
+    void setFilter(const QString &filter);
+    Q_SIGNAL void filterChanged() const;
+
+    // Superset element shown in row, for SubsetModel::setChecked().
+    Q_INVOKABLE int elementAtRow(int row) const;
+
+    virtual void setSourceModel(QAbstractItemModel *sourceModel);
+
+protected:
+
+    virtual bool filterAcceptsRow(int                sourceRow,
+                                  const QModelIndex &sourceParent) const;
+
+private:
+
+    Q_SLOT void sourceReset();
+
+    void indexSuperset();
+    bool matches(int element) const;
+    void updateMatches(bool narrower);
+
+    QPointer<SubsetModel> m_model;
+    QString m_filter;
+    QString m_foldedFilter;
+    QStringList m_filterWords;
+
+    QVariantList m_superset;
+    QVector<QStringList> m_words;
+    QBitArray m_matches;
+};
+
+#endif // SUBSET_FILTER_MODEL_H
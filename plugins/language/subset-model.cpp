@@ -19,6 +19,8 @@
  */
 
 #include "subset-model.h"
+#include <algorithm>
+#include <iterator>
 
 #define CHECKED_ROLE  (Qt::CheckStateRole)
 #define ENABLED_ROLE  (Qt::UserRole + 0)
@@ -28,18 +30,19 @@
 #define CUSTOM_ROLE   (Qt::UserRole + 4)
 
 bool
-changeLessThan(const SubsetModel::Change *change0,
-               const SubsetModel::Change *change1)
+SubsetModel::finishesBefore(qint64 finish, const Change &change)
 {
-    return change0->finish < change1->finish;
+    return finish < change.finish;
 }
 
 SubsetModel::SubsetModel(QObject *parent) :
     QAbstractListModel(parent),
     m_allowEmpty(true),
-    m_checked(0),
-    m_ignore(QDateTime::currentMSecsSinceEpoch())
+    m_checked(0)
 {
+    m_changeTimer.setSingleShot(true);
+    m_changeTimer.setTimerType(Qt::CoarseTimer);
+    connect(&m_changeTimer, SIGNAL(timeout()), SLOT(timerExpired()));
 }
 
 const QStringList &
@@ -70,27 +73,21 @@ SubsetModel::setSuperset(const QVariantList &superset)
     if (superset != m_superset) {
         beginResetModel();
 
-        for (QList<State *>::iterator i(m_state.begin()); i != m_state.end(); ++i)
-            delete *i;
-
-        m_ignore = QDateTime::currentMSecsSinceEpoch();
         m_superset = superset;
         m_subset.clear();
-        m_state.clear();
-        m_checked = 0;
 
-        for (int i(0); i < m_superset.length(); i++) {
-            State *state(new State);
-            state->checked = false;
-            state->check = m_ignore;
-            state->uncheck = m_ignore;
+        m_columns.clear();
+        m_columns.reserve(m_superset.length());
 
-            m_state += state;
-        }
+        for (int i(0); i < m_superset.length(); i++)
+            m_columns += m_superset[i].toList();
+
+        resetState();
 
         if (!m_allowEmpty && !m_superset.isEmpty()) {
             m_subset += 0;
-            m_state[0]->checked = true;
+            m_subsetRows[0] = 0;
+            m_checkedElements.setBit(0);
             m_checked = 1;
         }
 
@@ -113,30 +110,22 @@ SubsetModel::setSubset(const QList<int> &subset)
     if (subset != m_subset) {
         beginResetModel();
 
-        m_ignore = QDateTime::currentMSecsSinceEpoch();
         m_subset.clear();
-        m_checked = 0;
-
-        for (QList<State *>::iterator i(m_state.begin()); i != m_state.end(); ++i) {
-            (*i)->checked = false;
-            (*i)->check = m_ignore;
-            (*i)->uncheck = m_ignore;
-        }
+        resetState();
 
         for (QList<int>::const_iterator i(subset.begin()); i != subset.end(); ++i) {
-            if (0 <= *i && *i < m_superset.length()) {
+            if (0 <= *i && *i < m_superset.length() && !m_checkedElements.testBit(*i)) {
+                m_subsetRows[*i] = m_subset.length();
                 m_subset += *i;
-
-                if (!m_state[*i]->checked) {
-                    m_state[*i]->checked = true;
-                    m_checked++;
-                }
+                m_checkedElements.setBit(*i);
+                m_checked++;
             }
         }
 
         if (!m_allowEmpty && m_checked == 0 && !m_superset.isEmpty()) {
             m_subset += 0;
-            m_state[0]->checked = true;
+            m_subsetRows[0] = 0;
+            m_checkedElements.setBit(0);
             m_checked = 1;
         }
 
@@ -159,33 +148,20 @@ SubsetModel::setAllowEmpty(bool allowEmpty)
         m_allowEmpty = allowEmpty;
 
         // Check the first element if we can't have an empty subset.
-        if (!m_allowEmpty && m_state.length() > 0 && m_checked == 0) {
+        if (!m_allowEmpty && !m_superset.isEmpty() && m_checked == 0) {
+            m_subsetRows[0] = m_subset.length();
             m_subset += 0;
-            m_state[0]->checked = true;
+            m_checkedElements.setBit(0);
             m_checked = 1;
         }
 
         if (m_checked == 1) {
-            int single(-1);
-
-            for (int i(0); i < m_state.length(); i++) {
-                if (m_state[i]->checked) {
-                    single = i;
+            for (int i(0); i < m_checkedElements.size(); i++) {
+                if (m_checkedElements.testBit(i)) {
+                    emitElementChanged(i, ENABLED_ROLE);
                     break;
                 }
             }
-
-            for (int i(0); i < m_subset.length(); i++) {
-                if (m_subset[i] == single) {
-                    QModelIndex row(index(i, 0));
-                    Q_EMIT dataChanged(row, row, QVector<int>(1, ENABLED_ROLE));
-                }
-            }
-
-            if (single >= 0) {
-                QModelIndex row(index(m_subset.length() + single, 0));
-                Q_EMIT dataChanged(row, row, QVector<int>(1, ENABLED_ROLE));
-            }
         }
 
         Q_EMIT allowEmptyChanged();
@@ -195,7 +171,7 @@ SubsetModel::setAllowEmpty(bool allowEmpty)
 bool
 SubsetModel::checked(int element)
 {
-    return m_state[element]->checked;
+    return m_checkedElements.testBit(element);
 }
 
 void
@@ -206,12 +182,12 @@ SubsetModel::setChecked(int  element,
     qint64 time(QDateTime::currentMSecsSinceEpoch());
 
     if (checked)
-        m_state[element]->check = time;
+        m_checkTimes[element] = time;
     else
-        m_state[element]->uncheck = time;
+        m_uncheckTimes[element] = time;
 
-    if (checked != m_state[element]->checked) {
-        m_state[element]->checked = checked;
+    if (checked != m_checkedElements.testBit(element)) {
+        m_checkedElements.setBit(element, checked);
 
         if (checked)
             m_checked++;
@@ -219,47 +195,30 @@ SubsetModel::setChecked(int  element,
             m_checked--;
 
         if (!m_allowEmpty && (m_checked == 1 || (m_checked == 2 && checked))) {
-            int single(-1);
-
-            for (int i(0); i < m_state.length(); i++) {
-                if (i != element && m_state[i]->checked) {
-                    single = i;
+            for (int i(0); i < m_checkedElements.size(); i++) {
+                if (i != element && m_checkedElements.testBit(i)) {
+                    emitElementChanged(i, ENABLED_ROLE);
                     break;
                 }
             }
-
-            for (int i(0); i < m_subset.length(); i++) {
-                if (m_subset[i] == single) {
-                    QModelIndex row(index(i, 0));
-                    Q_EMIT dataChanged(row, row, QVector<int>(1, ENABLED_ROLE));
-                }
-            }
-
-            if (single >= 0) {
-                QModelIndex row(index(m_subset.length() + single, 0));
-                Q_EMIT dataChanged(row, row, QVector<int>(1, ENABLED_ROLE));
-            }
         }
 
-        for (int i(0); i < m_subset.length(); i++) {
-            if (m_subset[i] == element) {
-                QModelIndex row(index(i, 0));
-                Q_EMIT dataChanged(row, row, QVector<int>(1, CHECKED_ROLE));
-            }
-        }
+        emitElementChanged(element, CHECKED_ROLE);
 
-        QModelIndex row(index(m_subset.length() + element, 0));
-        Q_EMIT dataChanged(row, row, QVector<int>(1, CHECKED_ROLE));
+        Change change;
+        change.element = element;
+        change.checked = checked;
+        change.start = time;
+        change.finish = time + timeout;
 
-        Change *change(new Change);
-        change->element = element;
-        change->checked = checked;
-        change->start = time;
-        change->finish = time + timeout;
+        QVector<Change>::iterator i(std::upper_bound(m_changes.begin(), m_changes.end(),
+                                                     change.finish, finishesBefore));
+        bool first(i == m_changes.begin());
+        m_changes.insert(i, change);
 
-        m_change.insert(qUpperBound(m_change.begin(), m_change.end(), change, changeLessThan), change);
-
-        QTimer::singleShot(timeout, this, SLOT(timerExpired()));
+        // Only an earlier deadline needs the timer moved.
+        if (first)
+            scheduleChanges();
     }
 }
 
@@ -302,10 +261,10 @@ SubsetModel::data(const QModelIndex &index,
 {
     switch (role) {
     case CHECKED_ROLE:
-        return m_state[elementAtIndex(index)]->checked ? Qt::Checked : Qt::Unchecked;
+        return m_checkedElements.testBit(elementAtIndex(index)) ? Qt::Checked : Qt::Unchecked;
 
     case ENABLED_ROLE:
-        return m_allowEmpty || m_checked != 1 || !m_state[elementAtIndex(index)]->checked;
+        return m_allowEmpty || m_checked != 1 || !m_checkedElements.testBit(elementAtIndex(index));
 
     case SUBSET_ROLE:
     case SUPERSET_ROLE:
@@ -317,8 +276,7 @@ SubsetModel::data(const QModelIndex &index,
     }
 
     int column(role - CUSTOM_ROLE);
-    int element(elementAtIndex(index));
-    QVariantList list(m_superset[element].toList());
+    const QVariantList &list(m_columns[elementAtIndex(index)]);
 
     if (0 <= column && column < list.length())
         return list[column];
@@ -357,37 +315,89 @@ SubsetModel::setData(const QModelIndex &index,
 void
 SubsetModel::timerExpired()
 {
-    Change *change(m_change.first());
+    qint64 now(QDateTime::currentMSecsSinceEpoch());
+    QVector<Change>::iterator end(std::upper_bound(m_changes.begin(), m_changes.end(),
+                                                   now, finishesBefore));
 
-    m_change.removeFirst();
+    // Take them out first, the subset signals may queue new ones.
+    QVector<Change> expired;
+    std::copy(m_changes.begin(), end, std::back_inserter(expired));
+    m_changes.erase(m_changes.begin(), end);
 
-    if (change->start > m_ignore) {
-        if (change->checked) {
-            if (change->start > m_state[change->element]->uncheck) {
-                if (!m_subset.contains(change->element)) {
-                    beginInsertRows(QModelIndex(), m_subset.length(), m_subset.length());
-                    m_subset += change->element;
-                    endInsertRows();
+    Q_FOREACH(const Change &change, expired)
+        applyChange(change);
 
-                    Q_EMIT subsetChanged();
-                }
-            }
-        } else {
-            if (change->start > m_state[change->element]->check) {
-                for (int i(0); i < m_subset.length(); i++) {
-                    while (i < m_subset.length() && m_subset[i] == change->element) {
-                        beginRemoveRows(QModelIndex(), i, i);
-                        m_subset.removeAt(i);
-                        endRemoveRows();
-                    }
-                }
+    scheduleChanges();
+}
 
-                Q_EMIT subsetChanged();
-            }
+void
+SubsetModel::applyChange(const Change &change)
+{
+    int row(m_subsetRows[change.element]);
+
+    if (change.checked) {
+        if (change.start > m_uncheckTimes[change.element] && row < 0) {
+            beginInsertRows(QModelIndex(), m_subset.length(), m_subset.length());
+            m_subsetRows[change.element] = m_subset.length();
+            m_subset += change.element;
+            endInsertRows();
+
+            Q_EMIT subsetChanged();
+        }
+    } else {
+        if (change.start > m_checkTimes[change.element] && row >= 0) {
+            beginRemoveRows(QModelIndex(), row, row);
+            m_subset.removeAt(row);
+            m_subsetRows[change.element] = -1;
+
+            for (int i(row); i < m_subset.length(); i++)
+                m_subsetRows[m_subset[i]] = i;
+
+            endRemoveRows();
+
+            Q_EMIT subsetChanged();
         }
     }
+}
+
+void
+SubsetModel::scheduleChanges()
+{
+    if (m_changes.isEmpty()) {
+        m_changeTimer.stop();
+        return;
+    }
 
-    delete change;
+    qint64 wait(m_changes.first().finish - QDateTime::currentMSecsSinceEpoch());
+    m_changeTimer.start(qMax(qint64(0), wait));
+}
+
+void
+SubsetModel::resetState()
+{
+    // Pending changes refer to the previous subset.
+    m_changes.clear();
+    m_changeTimer.stop();
+
+    m_checkedElements.fill(false, m_superset.length());
+    m_checkTimes.fill(0, m_superset.length());
+    m_uncheckTimes.fill(0, m_superset.length());
+    m_subsetRows.fill(-1, m_superset.length());
+    m_checked = 0;
+}
+
+void
+SubsetModel::emitElementChanged(int element, int role)
+{
+    int row(m_subsetRows[element]);
+
+    if (row >= 0) {
+        QModelIndex subsetRow(index(row, 0));
+        Q_EMIT dataChanged(subsetRow, subsetRow, QVector<int>(1, role));
+    }
+
+    QModelIndex supersetRow(index(m_subset.length() + element, 0));
+    Q_EMIT dataChanged(supersetRow, supersetRow, QVector<int>(1, role));
 }
 
 int
@@ -423,5 +433,9 @@ SubsetModel::moveSubsetRow(int from, int to) {
     int newModelIndex = to > from ? to+1 : to;
     beginMoveRows(QModelIndex(), from, from, QModelIndex(), newModelIndex);
     m_subset.move(from, to);
+
+    for (int i(qMin(from, to)); i <= qMax(from, to); i++)
+        m_subsetRows[m_subset[i]] = i;
+
     endMoveRows();
 }
@@ -95,12 +95,6 @@ protected:
     virtual int elementAtRow(int row) const;
     virtual int elementAtIndex(const QModelIndex &index) const;
 
-    struct State {
-        bool checked;
-        qint64 check;
-        qint64 uncheck;
-    };
-
     struct Change {
         int element;
         bool checked;
@@ -108,19 +102,30 @@ protected:
         qint64 finish;
     };
 
+    static bool finishesBefore(qint64 finish, const Change &change);
+
+    void resetState();
+    void scheduleChanges();
+    void applyChange(const Change &change);
+    void emitElementChanged(int element, int role);
+
     QStringList m_customRoles;
     QVariantList m_superset;
     QList<int> m_subset;
     bool m_allowEmpty;
 
-    QList<State *> m_state;
-    QList<Change *> m_change;
+    // Per element, indexed like m_superset.
+    QVector<QVariantList> m_columns;
+    QBitArray m_checkedElements;
+    QVector<qint64> m_checkTimes;
+    QVector<qint64> m_uncheckTimes;
+    QVector<int> m_subsetRows;
 
-    int m_checked;
-    qint64 m_ignore;
+    // Pending subset changes ordered by finish, drained by one timer.
+    QVector<Change> m_changes;
+    QTimer m_changeTimer;
 
-    friend bool changeLessThan(const Change *change0,
-                               const Change *change1);
+    int m_checked;
 };
 
 #endif // SUBSET_MODEL_H
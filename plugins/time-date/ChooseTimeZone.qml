@@ -31,6 +31,8 @@ ItemPage {
     flickable: locationsListView
     property UbuntuTimeDatePanel timeDatePanel
 
+    Component.onCompleted: timeDatePanel.prepareTimeZoneSearch()
+
     Timer {
         id: goBackTimer
         onTriggered: removePages(changeTimeZonePage)
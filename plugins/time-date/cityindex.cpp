@@ -0,0 +1,156 @@
+/*
+ * Copyright (C) 2016 Canonical Ltd
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+*/
+
+#include "cityindex.h"
+
+#include <QHash>
+#include <algorithm>
+#include <cstring>
+
+#include <geonames.h>
+
+bool CityIndex::read(Cities *cities, gint count)
+{
+    gint first = cities->names.count();
+    gint last = qMin(first + count, geonames_get_n_cities());
+
+    for (gint i = first; i < last; ++i) {
+        GeonamesCity *city = geonames_get_city(i);
+
+        // Missing cities stay as empty names, to keep the ids in step.
+        QByteArray name;
+        guint population = 0;
+        if (city) {
+            name = geonames_city_get_name(city);
+            population = geonames_city_get_population(city);
+            geonames_city_free(city);
+        }
+
+        cities->names.append(name);
+        cities->populations.append(population);
+    }
+
+    return last < geonames_get_n_cities();
+}
+
+CityIndex CityIndex::build(const Cities &cities,
+                           QSharedPointer<QAtomicInt> cancelled)
+{
+    CityIndex index;
+    gint count = cities.names.count();
+
+    index.m_populations = cities.populations;
+    index.m_entries.reserve(count * 2);
+
+    for (gint i = 0; i < count; ++i) {
+        if (cancelled->loadAcquire())
+            return CityIndex();
+
+        QByteArray name = fold(QString::fromUtf8(cities.names[i]));
+        if (name.isEmpty())
+            continue;
+
+        quint32 start = index.m_names.size();
+        index.m_names.append(name).append('\0');
+
+        // The whole name, then each word after the first.
+        index.m_entries.append(Entry{start, i});
+        for (int j = 0; j < name.size(); ++j) {
+            if (name[j] == ' ')
+                index.m_entries.append(Entry{quint32(start + j + 1), i});
+        }
+    }
+
+    const char *names = index.m_names.constData();
+    std::sort(index.m_entries.begin(), index.m_entries.end(),
+              [names](const Entry &a, const Entry &b) {
+        int order = strcmp(names + a.key, names + b.key);
+        return order != 0 ? order < 0 : a.city < b.city;
+    });
+
+    return index;
+}
+
+bool CityIndex::isEmpty() const
+{
+    return m_entries.isEmpty();
+}
+
+QVector<gint> CityIndex::find(const QString &prefix) const
+{
+    QByteArray folded = fold(prefix);
+    if (folded.isEmpty())
+        return QVector<gint>();
+
+    const char *names = m_names.constData();
+    auto it = std::lower_bound(m_entries.begin(), m_entries.end(), folded,
+                               [names](const Entry &entry, const QByteArray &key) {
+        return strcmp(names + entry.key, key.constData()) < 0;
+    });
+
+    // A city can match through several of its words.
+    QHash<gint, bool> exact;
+    for (; it != m_entries.end(); ++it) {
+        const char *key = names + it->key;
+        if (strncmp(key, folded.constData(), folded.size()) != 0)
+            break;
+
+        bool whole = (it->key == 0 || names[it->key - 1] == '\0') &&
+                     key[folded.size()] == '\0';
+        exact[it->city] = exact.value(it->city) || whole;
+    }
+
+    QVector<gint> cities;
+    cities.reserve(exact.size());
+    for (auto hit = exact.constBegin(); hit != exact.constEnd(); ++hit)
+        cities.append(hit.key());
+
+    std::sort(cities.begin(), cities.end(), [&](gint a, gint b) {
+        if (exact.value(a) != exact.value(b))
+            return exact.value(a);
+        if (m_populations[a] != m_populations[b])
+            return m_populations[a] > m_populations[b];
+        return a < b;
+    });
+
+    return cities;
+}
+
+bool CityIndex::matches(const QByteArray &name, const QByteArray &prefix)
+{
+    return name.startsWith(prefix) || name.contains(' ' + prefix);
+}
+
+QByteArray CityIndex::fold(const QString &text)
+{
+    // "São Paulo" and "sao-paulo" both become "sao paulo".
+    const QString decomposed = text.normalized(QString::NormalizationForm_KD)
+                                   .toCaseFolded();
+    QString folded;
+    folded.reserve(decomposed.size());
+
+    Q_FOREACH(const QChar &c, decomposed) {
+        if (c.category() == QChar::Mark_NonSpacing)
+            continue;
+        if (c.isLetterOrNumber())
+            folded += c;
+        else if (!folded.isEmpty() && !folded.endsWith(' '))
+            folded += ' ';
+    }
+
+    return folded.trimmed().toUtf8();
+}
@@ -0,0 +1,81 @@
+/*
+ * Copyright (C) 2016 Canonical Ltd
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+*/
+
+#ifndef CITYINDEX_H
+#define CITYINDEX_H
+
+#include <QAtomicInt>
+#include <QByteArray>
+#include <QSharedPointer>
+#include <QString>
+#include <QVector>
+
+#include <glib.h>
+
+/*
+ * Prefix index over the names of all geonames cities.
+ *
+ * Names are folded to lower case without accents and stored once,
+ * back to back; the index is an array of offsets to the start of
+ * every name and of every word within it, sorted by the text there.
+ */
+class CityIndex
+{
+public:
+    // What an index is built from, in geonames order.
+    struct Cities {
+        QVector<QByteArray> names;
+        QVector<guint> populations;
+    };
+
+    // Appends up to count more cities from geonames; false once all
+    // have been read. libgeonames does not claim to be thread-safe, so
+    // this stays on the thread the rest of the model queries it from.
+    static bool read(Cities *cities, gint count);
+
+    // Folds and sorts the names, which takes a while: meant to run on
+    // a worker thread. Gives up with an empty index once cancelled is
+    // set, since nobody is waiting for it then.
+    static CityIndex build(const Cities &cities,
+                           QSharedPointer<QAtomicInt> cancelled);
+
+    bool isEmpty() const;
+
+    // Cities whose name, or a word of it, starts with prefix. Exact
+    // matches of the whole name come first, then the most populated;
+    // ties keep the geonames order so results do not jump around.
+    QVector<gint> find(const QString &prefix) const;
+
+    // Lower case, without accents, and words separated by single
+    // spaces: the form names are indexed and looked up in.
+    static QByteArray fold(const QString &text);
+    // Whether the folded name, or a word of it, starts with the folded
+    // prefix; the rule find() applies.
+    static bool matches(const QByteArray &name, const QByteArray &prefix);
+
+private:
+    struct Entry {
+        quint32 key;
+        gint city;
+    };
+
+    QByteArray m_names;
+    QVector<Entry> m_entries;
+    QVector<guint> m_populations;
+};
+
+#endif // CITYINDEX_H
@@ -184,6 +184,11 @@ QAbstractItemModel *TimeDate::getTimeZoneModel()
     return &m_timeZoneModel;
 }
 
+void TimeDate::prepareTimeZoneSearch()
+{
+    m_timeZoneModel.buildIndex();
+}
+
 QString TimeDate::getFilter()
 {
     return m_filter;
@@ -61,6 +61,8 @@ public:
     QString timeZoneName();
     bool useNTP();
     QAbstractItemModel *getTimeZoneModel();
+    // Readies instant search; call when the time zone picker opens.
+    Q_INVOKABLE void prepareTimeZoneSearch();
     QString getFilter();
     void setFilter (QString &filter);
     void setUseNTP(bool enabled);
@@ -24,22 +24,82 @@
 
 #include <QDebug>
 
+// Rows turned into cities per fetchMore().
+#define LOCATIONS_PAGE 50
+// Typing pause after which geonames is asked.
+#define QUERY_DELAY 200
+// Cities read from geonames per event loop pass while indexing.
+#define CITIES_PER_READ 1000
+
 TimeZoneLocationModel::TimeZoneLocationModel(QObject *parent):
     QAbstractTableModel(parent),
     modelUpdating(false),
+    m_fetched(0),
     m_cancellable(nullptr)
 {
+    m_queryTimer.setSingleShot(true);
+    m_queryTimer.setInterval(QUERY_DELAY);
+    connect(&m_queryTimer, SIGNAL(timeout()), this, SLOT(startQuery()));
+    m_readTimer.setInterval(0);
+    connect(&m_readTimer, SIGNAL(timeout()), this, SLOT(readCities()));
+    connect(&m_indexBuild, SIGNAL(finished()), this, SLOT(indexBuilt()));
 }
 
-void TimeZoneLocationModel::setModel(const QList<GeonamesCity *> &locations)
+void TimeZoneLocationModel::buildIndex()
 {
-    beginResetModel();
+    if (!m_index.isEmpty() || m_readTimer.isActive() || m_indexBuild.isRunning())
+        return;
 
-    Q_FOREACH(GeonamesCity *city, m_locations) {
-        geonames_city_free(city);
+    m_readTimer.start();
+}
+
+void TimeZoneLocationModel::readCities()
+{
+    // libgeonames is only ever called from this thread; the worker
+    // gets copies of what it needs.
+    if (CityIndex::read(&m_cities, CITIES_PER_READ))
+        return;
+
+    m_readTimer.stop();
+    m_indexCancelled = QSharedPointer<QAtomicInt>(new QAtomicInt(0));
+    m_indexBuild.setFuture(QtConcurrent::run(CityIndex::build, m_cities,
+                                             m_indexCancelled));
+    m_cities = CityIndex::Cities();
+}
+
+void TimeZoneLocationModel::indexBuilt()
+{
+    m_index = m_indexBuild.result();
+
+    // Answer whatever was typed meanwhile without waiting for geonames.
+    if (!m_pattern.isEmpty() && findInIndex()) {
+        cancelQuery();
+        modelUpdating = false;
+        Q_EMIT filterComplete();
     }
+}
+
+bool TimeZoneLocationModel::findInIndex()
+{
+    if (m_index.isEmpty())
+        return false;
+
+    QVector<gint> matches = m_index.find(m_pattern);
+    if (matches.isEmpty())
+        return false;
+
+    setMatches(matches);
+    return true;
+}
+
+void TimeZoneLocationModel::setMatches(const QVector<gint> &matches)
+{
+    beginResetModel();
+
+    m_matches = matches;
+    m_fetched = 0;
+    m_locations = nextLocations();
 
-    m_locations = locations;
     endResetModel();
 }
 
@@ -63,26 +123,23 @@ QVariant TimeZoneLocationModel::data(const QModelIndex &index, int role) const
             index.row() < 0)
         return QVariant();
 
-    GeonamesCity *city = m_locations[index.row()];
+    const Location &location = m_locations[index.row()];
 
     switch (role) {
     case Qt::DisplayRole:
-        return QVariant(QString("%1, %2, %3").arg(geonames_city_get_name(city))
-                                             .arg(geonames_city_get_state(city))
-                                             .arg(geonames_city_get_country(city)));
+        return location.displayName;
         break;
     case SimpleRole:
-        return QVariant(QString("%1, %2").arg(geonames_city_get_name(city))
-                                         .arg(geonames_city_get_country(city)));
+        return location.simpleName;
         break;
     case TimeZoneRole:
-        return geonames_city_get_timezone(city);
+        return location.timeZone;
         break;
     case CountryRole:
-        return geonames_city_get_country(city);
+        return location.country;
         break;
     case CityRole:
-        return geonames_city_get_name(city);
+        return location.city;
         break;
     default:
         return QVariant();
@@ -102,6 +159,55 @@ QHash<int, QByteArray> TimeZoneLocationModel::roleNames() const
     return m_roleNames;
 }
 
+bool TimeZoneLocationModel::canFetchMore(const QModelIndex &parent) const
+{
+    if (parent.isValid())
+        return false;
+    return m_fetched < m_matches.count();
+}
+
+void TimeZoneLocationModel::fetchMore(const QModelIndex &parent)
+{
+    if (parent.isValid())
+        return;
+
+    QVector<Location> locations = nextLocations();
+    if (locations.isEmpty())
+        return;
+
+    int first = m_locations.count();
+    beginInsertRows(QModelIndex(), first, first + locations.count() - 1);
+    m_locations += locations;
+    endInsertRows();
+}
+
+QVector<TimeZoneLocationModel::Location> TimeZoneLocationModel::nextLocations()
+{
+    QVector<Location> locations;
+
+    while (m_fetched < m_matches.count() && locations.count() < LOCATIONS_PAGE) {
+        GeonamesCity *city = geonames_get_city(m_matches[m_fetched++]);
+        if (!city)
+            continue;
+
+        Location location;
+        location.timeZone = geonames_city_get_timezone(city);
+        location.city = geonames_city_get_name(city);
+        location.country = geonames_city_get_country(city);
+        location.displayName = QString("%1, %2, %3").arg(location.city)
+                                                    .arg(geonames_city_get_state(city))
+                                                    .arg(location.country);
+        location.simpleName = QString("%1, %2").arg(location.city)
+                                               .arg(location.country);
+        location.foldedCity = CityIndex::fold(location.city);
+        locations.append(location);
+
+        geonames_city_free(city);
+    }
+
+    return locations;
+}
+
 void TimeZoneLocationModel::filterFinished(GObject      *source_object,
                                            GAsyncResult *res,
                                            gpointer      user_data)
@@ -118,49 +224,104 @@ void TimeZoneLocationModel::filterFinished(GObject      *source_object,
             TimeZoneLocationModel *model = static_cast<TimeZoneLocationModel *>(user_data);
             g_clear_object(&model->m_cancellable);
             qWarning() << "Could not filter timezones:" << error->message;
+
+            model->modelUpdating = false;
+            Q_EMIT model->filterComplete();
         }
         return;
     }
 
-    QList<GeonamesCity *> locations;
-
+    QVector<gint> matches(cities_len);
     for (guint i = 0; i < cities_len; ++i) {
-        GeonamesCity *city = geonames_get_city(cities[i]);
-        if (city) {
-            locations.append(city);
-        }
+        matches[i] = cities[i];
     }
 
     TimeZoneLocationModel *model = static_cast<TimeZoneLocationModel *>(user_data);
 
     g_clear_object(&model->m_cancellable);
 
-    model->setModel(locations);
+    model->setMatches(matches);
     model->modelUpdating = false;
 
     Q_EMIT model->filterComplete();
 }
 
-void TimeZoneLocationModel::filter(const QString& pattern)
+void TimeZoneLocationModel::narrow(const QString &pattern)
 {
-    modelUpdating = true;
-    Q_EMIT filterBegin();
+    // Cities not turned into rows yet cannot be checked without asking
+    // geonames, so they wait for the query; the rows shown are narrowed
+    // from the bottom up in runs, by the rule the index matches with.
+    const QByteArray prefix = CityIndex::fold(pattern);
+    int end = m_locations.count();
+    while (end > 0) {
+        int last = end - 1;
+        while (last >= 0 &&
+               CityIndex::matches(m_locations[last].foldedCity, prefix))
+            last--;
+        if (last < 0)
+            break;
+
+        int first = last;
+        while (first > 0 &&
+               !CityIndex::matches(m_locations[first - 1].foldedCity, prefix))
+            first--;
+
+        beginRemoveRows(QModelIndex(), first, last);
+        m_locations.remove(first, last - first + 1);
+        endRemoveRows();
+
+        end = first;
+    }
+
+    m_matches.clear();
+    m_fetched = 0;
+}
+
+void TimeZoneLocationModel::cancelQuery()
+{
+    m_queryTimer.stop();
 
     if (m_cancellable) {
         g_cancellable_cancel(m_cancellable);
         g_clear_object(&m_cancellable);
     }
+}
 
-    setModel(QList<GeonamesCity *>());
+void TimeZoneLocationModel::filter(const QString& pattern)
+{
+    bool narrower = !m_pattern.isEmpty() &&
+                    pattern.startsWith(m_pattern, Qt::CaseInsensitive);
+
+    m_pattern = pattern;
+    cancelQuery();
 
     if (pattern.isEmpty()) {
+        setMatches(QVector<gint>());
+        modelUpdating = false;
+        Q_EMIT filterComplete();
+        return;
+    }
+
+    modelUpdating = true;
+    Q_EMIT filterBegin();
+
+    if (findInIndex()) {
         modelUpdating = false;
         Q_EMIT filterComplete();
         return;
     }
 
+    // Whatever was shown stays until the query replaces it.
+    if (narrower)
+        narrow(pattern);
+
+    m_queryTimer.start();
+}
+
+void TimeZoneLocationModel::startQuery()
+{
     m_cancellable = g_cancellable_new();
-    geonames_query_cities(pattern.toUtf8().data(),
+    geonames_query_cities(m_pattern.toUtf8().data(),
                           GEONAMES_QUERY_DEFAULT,
                           m_cancellable,
                           filterFinished,
@@ -169,12 +330,10 @@ void TimeZoneLocationModel::filter(const QString& pattern)
 
 TimeZoneLocationModel::~TimeZoneLocationModel()
 {
-    if (m_cancellable) {
-        g_cancellable_cancel(m_cancellable);
-        g_clear_object(&m_cancellable);
-    }
+    cancelQuery();
 
-    Q_FOREACH(GeonamesCity *city, m_locations) {
-        geonames_city_free(city);
-    }
+    // Not waited for: the build only touches its own copies, and gives
+    // up soon; its result is dropped with the future.
+    if (m_indexCancelled)
+        m_indexCancelled->storeRelease(1);
 }
@@ -24,11 +24,15 @@
 #include <QAbstractTableModel>
 #include <QSet>
 #include <QThread>
+#include <QTimer>
+#include <QVector>
 
 #include <QtConcurrent>
 
 #include <geonames.h>
 
+#include "cityindex.h"
+
 class TimeZoneLocationModel : public QAbstractTableModel
 {
     Q_OBJECT
@@ -44,13 +48,23 @@ public:
         SimpleRole
     };
 
+    // Narrows the shown rows at once when pattern extends the previous
+    // one, and queries geonames once typing pauses.
     void filter(const QString& pattern);
 
+    // Starts building the city index, once: the cities are read from
+    // geonames in slices between events, then indexed on a worker
+    // thread. Until it is ready, and for patterns it has nothing for
+    // (alternate names, say), filter() queries geonames.
+    void buildIndex();
+
     // implemented virtual methods from QAbstractTableModel
     int rowCount (const QModelIndex &parent = QModelIndex()) const;
     int columnCount(const QModelIndex &parent = QModelIndex()) const;
     QVariant data (const QModelIndex &index, int role = Qt::DisplayRole) const;
     QHash<int, QByteArray> roleNames() const;
+    bool canFetchMore(const QModelIndex &parent) const;
+    void fetchMore(const QModelIndex &parent);
 
     bool modelUpdating;
 
@@ -58,14 +72,47 @@ Q_SIGNALS:
     void filterBegin();
     void filterComplete();
 
+private Q_SLOTS:
+    void startQuery();
+    void readCities();
+    void indexBuilt();
+
 private:
-    QList<GeonamesCity *> m_locations;
+    // A city as shown, with its strings formatted once.
+    struct Location {
+        QString timeZone;
+        QString city;
+        QString country;
+        QString displayName;
+        QString simpleName;
+        // city as CityIndex folds it, for narrowing.
+        QByteArray foldedCity;
+    };
+
+    // geonames city ids of the last query, in its order; only the
+    // first m_fetched of them have been turned into m_locations.
+    QVector<gint> m_matches;
+    int m_fetched;
+    QVector<Location> m_locations;
+    QString m_pattern;
+    QTimer m_queryTimer;
     GCancellable *m_cancellable;
+    CityIndex m_index;
+    CityIndex::Cities m_cities;
+    QTimer m_readTimer;
+    QFutureWatcher<CityIndex> m_indexBuild;
+    // Shared with the build, which outlives the model if need be.
+    QSharedPointer<QAtomicInt> m_indexCancelled;
 
     static void filterFinished(GObject      *source_object,
                                GAsyncResult *res,
                                gpointer      user_data);
-    void setModel(const QList<GeonamesCity *> &locations);
+    void setMatches(const QVector<gint> &matches);
+    // Turns the next page of matches into locations.
+    QVector<Location> nextLocations();
+    void narrow(const QString &pattern);
+    void cancelQuery();
+    bool findInIndex();
 };
 
 #endif // TIMEZONELOCATIONMODEL_H
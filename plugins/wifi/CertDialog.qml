@@ -29,6 +29,13 @@ Component {
 
         FileHandler {
             id: fileHandler
+            onImportFinished: {
+                /* The import copies the file, the source is not needed
+                anymore whatever the outcome */
+                fileHandler.removeFile(certDialog.fileName);
+                certDialog.updateSignal(success);
+                PopupUtils.close(certDialog);
+            }
         }
 
         Label {
@@ -73,20 +80,16 @@ Component {
                 id: saveButton
                 text: i18n.tr("Save")
                 Layout.fillWidth: true
-                enabled: (certDialog.certContent.text !== "")
-                onClicked: { if (certType === 0) { // certificate
-                        fileHandler.moveCertFile(certDialog.fileName);
-                    } else if (certType === 1) { // privatekey
-                        fileHandler.moveKeyFile(certDialog.fileName);
-                    } else if (certType === 2) { // pacFile
-                        fileHandler.movePacFile(certDialog.fileName);
+                enabled: (certDialog.certContent.text !== "") &&
+                         !fileHandler.importing
+                onClicked: {
+                    // certType is one of FileHandler.Certificate,
+                    // FileHandler.PrivateKey and FileHandler.PacFile
+                    if (!fileHandler.importFile(certDialog.fileName, certType)) {
+                        fileHandler.removeFile(certDialog.fileName);
+                        certDialog.updateSignal(false);
+                        PopupUtils.close(certDialog);
                     }
-
-                    /* Just to be sure source file will be deleted if move was
-                    not successfull */
-                    fileHandler.removeFile(certDialog.fileName);
-                    certDialog.updateSignal(true);
-                    PopupUtils.close(certDialog);
                 }
             }
         }
@@ -37,6 +37,17 @@ ItemPage {
 
     title: i18n.tr("Network details")
 
+    Component.onCompleted: DbusHelper.fetchPassword(dbusPath)
+
+    Connections {
+        target: DbusHelper
+        onPasswordFetched: {
+            if (dbusPath === networkDetails.dbusPath) {
+                networkDetails.password = password;
+            }
+        }
+    }
+
     Flickable {
         anchors.fill: parent
         contentHeight: contentItem.childrenRect.height
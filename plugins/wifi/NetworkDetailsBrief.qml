@@ -57,6 +57,7 @@ ItemPage {
                         margins: units.gu(2)
                     }
                     onClicked: {
+                        // False only without a wifi device to forget on.
                         if (DbusHelper.forgetActiveDevice()) {
                             accessPoint.checked = false;
                             accessPoint.checkedChanged(false)
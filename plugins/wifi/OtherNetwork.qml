@@ -67,21 +67,13 @@ Component {
                     certDialogLoader.source = Qt.resolvedUrl(
                         "./CertDialog.qml"
                     );
+                    // The list models pick up saved files by themselves.
                     certDialog = PopupUtils.open(
                         certDialogLoader.item, authListLabel, {
                             fileName: file,
                             certType: type
                         }
                     );
-                    certDialog.updateSignal.connect(function (update) {
-                        if (update && type === 0) {
-                            cacertListModel.dataupdate();
-                        } else if (update && type === 1) {
-                            privatekeyListModel.dataupdate();
-                        } else if (update && type === 2) {
-                            pacFileListModeL.dataupdate();
-                        }
-                    });
                 }
             });
         }
@@ -995,6 +987,15 @@ Component {
                     }
                 }
             }
+
+            onConnectFinished: {
+                /* The connection request itself was refused, the device
+                will not report any state change for it */
+                if (!success && otherNetworkDialog.state === "CONNECTING") {
+                    feedback.text = error;
+                    otherNetworkDialog.state = "FAILED";
+                }
+            }
         }
     }
 }
@@ -59,8 +59,8 @@ ItemPage {
             text: name
             onClicked: pageStack.addPageToNextColumn(previousNetworks,
                 Qt.resolvedUrl("NetworkDetails.qml"), {
-                    networkName : name, password : password,
-                    lastUsed : lastUsed, dbusPath : objectPath
+                    networkName : name, lastUsed : lastUsed,
+                    dbusPath : objectPath
                 }
             )
         }
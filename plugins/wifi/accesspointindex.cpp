@@ -0,0 +1,244 @@
+/*
+ * Copyright (C) 2016 Canonical, Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3, as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "accesspointindex.h"
+#include <QtDebug>
+
+#define NM_SERVICE "org.freedesktop.NetworkManager"
+#define NM_AP_IFACE "org.freedesktop.NetworkManager.AccessPoint"
+#define NM_DEVICE_WIRELESS_IFACE "org.freedesktop.NetworkManager.Device.Wireless"
+#define DBUS_PROPERTIES_IFACE "org.freedesktop.DBus.Properties"
+
+AccessPointIndex::AccessPointIndex(const QDBusConnection &dbus,
+                                   const QString &devicePath,
+                                   QObject *parent)
+    : QObject(parent)
+    , m_dbus(dbus)
+    , m_devicePath(devicePath)
+    , m_pendingFetches(0)
+    , m_listed(false)
+{
+    // Subscribe before listing so that nothing falls in between.
+    m_dbus.connect(NM_SERVICE, m_devicePath, NM_DEVICE_WIRELESS_IFACE,
+                   "AccessPointAdded",
+                   this, SLOT(accessPointAdded(QDBusObjectPath)));
+    m_dbus.connect(NM_SERVICE, m_devicePath, NM_DEVICE_WIRELESS_IFACE,
+                   "AccessPointRemoved",
+                   this, SLOT(accessPointRemoved(QDBusObjectPath)));
+    // One match rule for every access point rather than one per path.
+    m_dbus.connect(NM_SERVICE, QString(), NM_AP_IFACE,
+                   "PropertiesChanged",
+                   this, SLOT(accessPointPropertiesChanged(QVariantMap, QDBusMessage)));
+
+    QDBusMessage msg = QDBusMessage::createMethodCall(NM_SERVICE,
+                                                      m_devicePath,
+                                                      NM_DEVICE_WIRELESS_IFACE,
+                                                      "GetAllAccessPoints");
+    auto watcher = new QDBusPendingCallWatcher(m_dbus.asyncCall(msg), this);
+    QObject::connect(watcher, SIGNAL(finished(QDBusPendingCallWatcher*)),
+                     this, SLOT(accessPointsListed(QDBusPendingCallWatcher*)));
+}
+
+QSharedPointer<AccessPointIndex> AccessPointIndex::shared(const QDBusConnection &dbus,
+                                                         const QString &devicePath)
+{
+    static QHash<QString, QWeakPointer<AccessPointIndex>> indices;
+
+    const QString key = dbus.name() + ' ' + devicePath;
+    QSharedPointer<AccessPointIndex> index = indices.value(key).toStrongRef();
+    if (!index) {
+        index = QSharedPointer<AccessPointIndex>(new AccessPointIndex(dbus, devicePath),
+                                                 &QObject::deleteLater);
+        indices.insert(key, index);
+    }
+    return index;
+}
+
+QString AccessPointIndex::devicePath() const
+{
+    return m_devicePath;
+}
+
+bool AccessPointIndex::isReady() const
+{
+    return m_listed && m_pendingFetches == 0;
+}
+
+QDBusObjectPath AccessPointIndex::find(const QByteArray &ssid) const
+{
+    QString best;
+    uint bestStrength = 0;
+
+    auto it = m_pathsBySsid.constFind(ssid);
+    for (; it != m_pathsBySsid.constEnd() && it.key() == ssid; ++it) {
+        uint strength = m_accessPoints.value(it.value()).strength;
+        if (best.isEmpty() || strength > bestStrength) {
+            best = it.value();
+            bestStrength = strength;
+        }
+    }
+
+    return QDBusObjectPath(best.isEmpty() ? QString("/") : best);
+}
+
+QList<QByteArray> AccessPointIndex::ssids() const
+{
+    return m_pathsBySsid.uniqueKeys();
+}
+
+uint AccessPointIndex::strength(const QByteArray &ssid) const
+{
+    uint strongest = 0;
+    auto it = m_pathsBySsid.constFind(ssid);
+    for (; it != m_pathsBySsid.constEnd() && it.key() == ssid; ++it) {
+        strongest = qMax(strongest, m_accessPoints.value(it.value()).strength);
+    }
+    return strongest;
+}
+
+bool AccessPointIndex::isSecured(const QByteArray &ssid) const
+{
+    auto it = m_pathsBySsid.constFind(ssid);
+    for (; it != m_pathsBySsid.constEnd() && it.key() == ssid; ++it) {
+        if (m_accessPoints.value(it.value()).isSecured())
+            return true;
+    }
+    return false;
+}
+
+void AccessPointIndex::accessPointsListed(QDBusPendingCallWatcher *call)
+{
+    QDBusPendingReply<QList<QDBusObjectPath>> reply = *call;
+    call->deleteLater();
+
+    if (reply.isError()) {
+        qWarning() << "Could not list access points of" << m_devicePath
+                   << ":" << reply.error().message();
+    } else {
+        for (const auto &ap : reply.value()) {
+            fetch(ap.path());
+        }
+    }
+
+    m_listed = true;
+    checkReady();
+}
+
+void AccessPointIndex::fetch(const QString &path)
+{
+    QDBusMessage msg = QDBusMessage::createMethodCall(NM_SERVICE,
+                                                      path,
+                                                      DBUS_PROPERTIES_IFACE,
+                                                      "GetAll");
+    msg << QString(NM_AP_IFACE);
+    auto watcher = new QDBusPendingCallWatcher(m_dbus.asyncCall(msg), this);
+    watcher->setProperty("path", path);
+    QObject::connect(watcher, SIGNAL(finished(QDBusPendingCallWatcher*)),
+                     this, SLOT(accessPointFetched(QDBusPendingCallWatcher*)));
+    m_pendingFetches++;
+}
+
+void AccessPointIndex::accessPointFetched(QDBusPendingCallWatcher *call)
+{
+    QDBusPendingReply<QVariantMap> reply = *call;
+    QString path = call->property("path").toString();
+    call->deleteLater();
+    m_pendingFetches--;
+
+    if (reply.isError()) {
+        // Most likely the access point went away in the meantime.
+        qWarning() << "Could not get properties of" << path << ":"
+                   << reply.error().message();
+    } else {
+        update(path, reply.value());
+    }
+
+    checkReady();
+}
+
+void AccessPointIndex::update(const QString &path, const QVariantMap &properties)
+{
+    auto it = m_accessPoints.find(path);
+    if (it == m_accessPoints.end()) {
+        AccessPoint ap;
+        ap.ssid = properties.value("Ssid").toByteArray();
+        ap.strength = properties.value("Strength").toUInt();
+        ap.flags = properties.value("Flags").toUInt();
+        ap.wpaFlags = properties.value("WpaFlags").toUInt();
+        ap.rsnFlags = properties.value("RsnFlags").toUInt();
+        m_accessPoints.insert(path, ap);
+        m_pathsBySsid.insert(ap.ssid, path);
+        Q_EMIT changed(ap.ssid);
+        return;
+    }
+
+    if (properties.contains("Ssid")) {
+        QByteArray ssid = properties.value("Ssid").toByteArray();
+        if (ssid != it->ssid) {
+            QByteArray old = it->ssid;
+            m_pathsBySsid.remove(it->ssid, path);
+            m_pathsBySsid.insert(ssid, path);
+            it->ssid = ssid;
+            Q_EMIT changed(old);
+        }
+    }
+    if (properties.contains("Strength")) {
+        it->strength = properties.value("Strength").toUInt();
+    }
+    if (properties.contains("Flags")) {
+        it->flags = properties.value("Flags").toUInt();
+    }
+    if (properties.contains("WpaFlags")) {
+        it->wpaFlags = properties.value("WpaFlags").toUInt();
+    }
+    if (properties.contains("RsnFlags")) {
+        it->rsnFlags = properties.value("RsnFlags").toUInt();
+    }
+    Q_EMIT changed(it->ssid);
+}
+
+void AccessPointIndex::checkReady()
+{
+    if (isReady())
+        Q_EMIT ready();
+}
+
+void AccessPointIndex::accessPointAdded(const QDBusObjectPath &path)
+{
+    fetch(path.path());
+}
+
+void AccessPointIndex::accessPointRemoved(const QDBusObjectPath &path)
+{
+    auto it = m_accessPoints.find(path.path());
+    if (it == m_accessPoints.end())
+        return;
+
+    QByteArray ssid = it->ssid;
+    m_pathsBySsid.remove(ssid, path.path());
+    m_accessPoints.erase(it);
+    Q_EMIT changed(ssid);
+}
+
+void AccessPointIndex::accessPointPropertiesChanged(const QVariantMap &properties,
+                                                    const QDBusMessage &message)
+{
+    // Access points of other devices share the match rule.
+    if (!m_accessPoints.contains(message.path()))
+        return;
+
+    update(message.path(), properties);
+}
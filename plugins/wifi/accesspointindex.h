@@ -0,0 +1,98 @@
+/*
+ * Copyright (C) 2016 Canonical, Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3, as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ACCESS_POINT_INDEX_H
+#define ACCESS_POINT_INDEX_H
+
+#include <QHash>
+#include <QObject>
+#include <QSharedPointer>
+#include <QtDBus>
+
+/**
+ * SSID to access point lookup for one wireless device.
+ *
+ * The index is filled with one GetAllAccessPoints call followed by a
+ * GetAll per access point, all in flight at the same time, and is then
+ * kept current from the device's AccessPointAdded/AccessPointRemoved
+ * signals, so lookups never touch the bus.
+ */
+class AccessPointIndex final : public QObject {
+    Q_OBJECT
+
+public:
+    explicit AccessPointIndex(const QDBusConnection &dbus,
+                              const QString &devicePath,
+                              QObject *parent = nullptr);
+    ~AccessPointIndex() {};
+
+    /* The index of devicePath that everyone in the process holding one
+       shares, so that each access point is fetched and watched once. */
+    static QSharedPointer<AccessPointIndex> shared(const QDBusConnection &dbus,
+                                                   const QString &devicePath);
+
+    QString devicePath() const;
+    /* False while any access point is still being fetched. */
+    bool isReady() const;
+
+    /* The strongest access point advertising ssid, or "/" if none does. */
+    QDBusObjectPath find(const QByteArray &ssid) const;
+
+    QList<QByteArray> ssids() const;
+    /* Strength of the strongest access point advertising ssid. */
+    uint strength(const QByteArray &ssid) const;
+    /* Whether any access point advertising ssid asks for credentials. */
+    bool isSecured(const QByteArray &ssid) const;
+
+Q_SIGNALS:
+    // Emitted each time the last pending fetch completes.
+    void ready();
+    // An access point advertising ssid appeared, went away or changed.
+    void changed(const QByteArray &ssid);
+
+private Q_SLOTS:
+    void accessPointAdded(const QDBusObjectPath &path);
+    void accessPointRemoved(const QDBusObjectPath &path);
+    void accessPointsListed(QDBusPendingCallWatcher *call);
+    void accessPointFetched(QDBusPendingCallWatcher *call);
+    void accessPointPropertiesChanged(const QVariantMap &properties,
+                                      const QDBusMessage &message);
+
+private:
+    struct AccessPoint {
+        QByteArray ssid;
+        uint strength;
+        // Changes may carry any one of them.
+        uint flags;
+        uint wpaFlags;
+        uint rsnFlags;
+
+        bool isSecured() const { return flags || wpaFlags || rsnFlags; }
+    };
+
+    void fetch(const QString &path);
+    void update(const QString &path, const QVariantMap &properties);
+    void checkReady();
+
+    QDBusConnection m_dbus;
+    QString m_devicePath;
+    QHash<QString, AccessPoint> m_accessPoints;
+    QMultiHash<QByteArray, QString> m_pathsBySsid;
+    int m_pendingFetches;
+    bool m_listed;
+};
+
+#endif
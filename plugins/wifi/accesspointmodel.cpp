@@ -0,0 +1,250 @@
+/*
+ * Copyright (C) 2016 Canonical, Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3, as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "accesspointmodel.h"
+#include "accesspointindex.h"
+#include "networkmanagermirror.h"
+
+#include <algorithm>
+
+namespace {
+    const int UPDATE_INTERVAL = 500;
+    const int SORT_INTERVAL = 3000;
+    const int STRENGTH_HYSTERESIS = 10;
+}
+
+AccessPointModel::AccessPointModel(QObject *parent)
+    : AccessPointModel(QDBusConnection::systemBus(), parent)
+{
+}
+
+AccessPointModel::AccessPointModel(const QDBusConnection &dbus,
+                                   QObject *parent)
+    : QAbstractListModel(parent)
+    , m_dbus(dbus)
+    , m_mirror(NetworkManagerMirror::shared(dbus))
+{
+    m_updateTimer.setSingleShot(true);
+    m_updateTimer.setInterval(UPDATE_INTERVAL);
+    connect(&m_updateTimer, SIGNAL(timeout()), this, SLOT(applyChanges()));
+    m_sortTimer.setSingleShot(true);
+    connect(&m_sortTimer, SIGNAL(timeout()), this, SLOT(sort()));
+    connect(m_mirror.data(), SIGNAL(changed()), this, SLOT(mirrorChanged()));
+    m_sinceSort.start();
+
+    // The shared mirror may have been filled already.
+    mirrorChanged();
+}
+
+void AccessPointModel::mirrorChanged()
+{
+    QString device = m_mirror->wifiDevice();
+    if (m_index ? m_index->devicePath() == device : device.isEmpty())
+        return;
+
+    if (m_index) {
+        disconnect(m_index.data(), nullptr, this, nullptr);
+        m_index.reset();
+    }
+    m_dirty.clear();
+
+    if (!m_networks.isEmpty()) {
+        beginResetModel();
+        m_networks.clear();
+        endResetModel();
+        Q_EMIT countChanged();
+    }
+
+    if (!device.isEmpty()) {
+        m_index = AccessPointIndex::shared(m_dbus, device);
+        connect(m_index.data(), SIGNAL(changed(QByteArray)),
+                this, SLOT(accessPointChanged(QByteArray)));
+
+        // Whatever the shared index already knows is not announced again.
+        Q_FOREACH(const QByteArray &ssid, m_index->ssids())
+            accessPointChanged(ssid);
+    }
+}
+
+void AccessPointModel::accessPointChanged(const QByteArray &ssid)
+{
+    // Hidden networks are not listed.
+    if (ssid.isEmpty())
+        return;
+
+    m_dirty.insert(ssid);
+    // Not restarted, so that a busy scan still shows up every interval.
+    if (!m_updateTimer.isActive())
+        m_updateTimer.start(UPDATE_INTERVAL);
+}
+
+void AccessPointModel::applyChanges()
+{
+    const QSet<QByteArray> dirty = m_dirty;
+    m_dirty.clear();
+
+    Q_FOREACH(const QByteArray &ssid, dirty) {
+        int row = rowOf(ssid);
+        QString path = m_index ? m_index->find(ssid).path() : QString("/");
+
+        if (path == "/") {
+            if (row >= 0) {
+                beginRemoveRows(QModelIndex(), row, row);
+                m_networks.removeAt(row);
+                endRemoveRows();
+                Q_EMIT countChanged();
+            }
+            continue;
+        }
+
+        Network network;
+        network.ssid = ssid;
+        network.name = QString::fromUtf8(ssid);
+        network.strength = m_index->strength(ssid);
+        network.secured = m_index->isSecured(ssid);
+        network.path = path;
+
+        if (row < 0) {
+            row = insertionRow(network);
+            beginInsertRows(QModelIndex(), row, row);
+            m_networks.insert(row, network);
+            endInsertRows();
+            Q_EMIT countChanged();
+            continue;
+        }
+
+        Network &current = m_networks[row];
+        QVector<int> roles;
+        if (qAbs(int(network.strength) - int(current.strength)) >= STRENGTH_HYSTERESIS) {
+            current.strength = network.strength;
+            roles << StrengthRole;
+        }
+        if (network.secured != current.secured) {
+            current.secured = network.secured;
+            roles << SecuredRole;
+        }
+        if (network.path != current.path) {
+            current.path = network.path;
+            roles << AccessPointPathRole;
+        }
+        if (!roles.isEmpty()) {
+            QModelIndex changed = index(row, 0);
+            Q_EMIT dataChanged(changed, changed, roles);
+        }
+    }
+
+    if (std::is_sorted(m_networks.begin(), m_networks.end(), lessThan))
+        return;
+
+    qint64 elapsed = m_sinceSort.elapsed();
+    if (elapsed >= SORT_INTERVAL) {
+        sort();
+    } else if (!m_sortTimer.isActive()) {
+        // A timer of its own, so that updates keep their own pace.
+        m_sortTimer.start(SORT_INTERVAL - elapsed);
+    }
+}
+
+/* Moves rows into place one at a time, so that views only animate the
+   rows that actually changed position. */
+void AccessPointModel::sort()
+{
+    m_sortTimer.stop();
+
+    QList<Network> sorted = m_networks;
+    std::stable_sort(sorted.begin(), sorted.end(), lessThan);
+
+    for (int i = 0; i < sorted.size(); i++) {
+        if (m_networks[i].ssid == sorted[i].ssid)
+            continue;
+
+        int from = i + 1;
+        while (m_networks[from].ssid != sorted[i].ssid)
+            from++;
+
+        beginMoveRows(QModelIndex(), from, from, QModelIndex(), i);
+        m_networks.move(from, i);
+        endMoveRows();
+    }
+
+    m_sinceSort.restart();
+}
+
+bool AccessPointModel::lessThan(const Network &a, const Network &b)
+{
+    if (a.strength != b.strength)
+        return a.strength > b.strength;
+    return QString::compare(a.name, b.name, Qt::CaseInsensitive) < 0;
+}
+
+int AccessPointModel::insertionRow(const Network &network) const
+{
+    // While a re-sort is held back, new rows wait for it at the end.
+    if (!std::is_sorted(m_networks.begin(), m_networks.end(), lessThan))
+        return m_networks.size();
+
+    return std::upper_bound(m_networks.begin(), m_networks.end(),
+                            network, lessThan) - m_networks.begin();
+}
+
+int AccessPointModel::rowOf(const QByteArray &ssid) const
+{
+    for (int i = 0; i < m_networks.size(); i++) {
+        if (m_networks[i].ssid == ssid)
+            return i;
+    }
+    return -1;
+}
+
+QHash<int, QByteArray> AccessPointModel::roleNames() const
+{
+    QHash<int, QByteArray> roles;
+    roles[SsidRole] = "ssid";
+    roles[StrengthRole] = "strength";
+    roles[SecuredRole] = "secured";
+    roles[AccessPointPathRole] = "accessPointPath";
+    return roles;
+}
+
+int AccessPointModel::rowCount(const QModelIndex &parent) const
+{
+    if (parent.isValid())
+        return 0;
+    return m_networks.size();
+}
+
+QVariant AccessPointModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || index.row() >= m_networks.size())
+        return QVariant();
+
+    const Network &network = m_networks[index.row()];
+
+    switch (role) {
+    case Qt::DisplayRole:
+    case SsidRole:
+        return network.name;
+    case StrengthRole:
+        return network.strength;
+    case SecuredRole:
+        return network.secured;
+    case AccessPointPathRole:
+        return network.path;
+    default:
+        return QVariant();
+    }
+}
@@ -0,0 +1,94 @@
+/*
+ * Copyright (C) 2016 Canonical, Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3, as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef ACCESS_POINT_MODEL_H
+#define ACCESS_POINT_MODEL_H
+
+#include <QAbstractListModel>
+#include <QElapsedTimer>
+#include <QSet>
+#include <QSharedPointer>
+#include <QTimer>
+#include <QtDBus>
+
+class AccessPointIndex;
+class NetworkManagerMirror;
+
+/**
+ * The networks seen by the wifi device, one row per SSID.
+ *
+ * Rows are fed from NetworkManager signals. Changes are collected and
+ * applied at most every UPDATE_INTERVAL ms, a row's strength only follows
+ * the access points once it moved by more than STRENGTH_HYSTERESIS, and
+ * rows are re-sorted at most every SORT_INTERVAL ms so that the list does
+ * not jump around while it is being looked at.
+ */
+class AccessPointModel : public QAbstractListModel
+{
+    Q_OBJECT
+    Q_PROPERTY(int count READ rowCount NOTIFY countChanged)
+
+public:
+    enum Roles {
+        SsidRole = Qt::UserRole + 1,
+        StrengthRole,
+        SecuredRole,
+        AccessPointPathRole,
+    };
+
+    explicit AccessPointModel(QObject *parent = nullptr);
+    explicit AccessPointModel(const QDBusConnection &dbus,
+                              QObject *parent = nullptr);
+    ~AccessPointModel() {};
+
+    QHash<int, QByteArray> roleNames() const;
+    int rowCount(const QModelIndex &parent = QModelIndex()) const;
+    QVariant data(const QModelIndex &index, int role) const;
+
+Q_SIGNALS:
+    void countChanged();
+
+private Q_SLOTS:
+    void mirrorChanged();
+    void accessPointChanged(const QByteArray &ssid);
+    void applyChanges();
+    void sort();
+
+private:
+    struct Network {
+        QByteArray ssid;
+        QString name;
+        uint strength;
+        bool secured;
+        QString path;
+    };
+
+    static bool lessThan(const Network &a, const Network &b);
+    int insertionRow(const Network &network) const;
+    int rowOf(const QByteArray &ssid) const;
+
+    QDBusConnection m_dbus;
+    QSharedPointer<NetworkManagerMirror> m_mirror;
+    QSharedPointer<AccessPointIndex> m_index;
+    QList<Network> m_networks;
+    QSet<QByteArray> m_dirty;
+    QTimer m_updateTimer;
+    QTimer m_sortTimer;
+    QElapsedTimer m_sinceSort;
+};
+
+#endif
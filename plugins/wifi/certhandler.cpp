@@ -9,6 +9,13 @@
 #include <QAbstractListModel>
 #include <QDir>
 #include <QFile>
+#include <QFileSystemWatcher>
+#include <QFutureWatcher>
+#include <QMutex>
+#include <QSaveFile>
+#include <QSet>
+#include <QtConcurrent>
+#include <algorithm>
 
 
 QString appPath = QStandardPaths::writableLocation(QStandardPaths::DataLocation);
@@ -92,22 +99,335 @@ bool FileHandler::removeFile(QString filename){
     return file.remove();
 }
 
+/* What the models show of a certificate or key file. Parsing is done once
+   per file on a worker thread and cached by path, size and mtime. */
+struct CertFileInfo {
+    QString fileName;
+    qint64 size = 0;
+    QDateTime modified;
+
+    QString commonName;
+    QString organization;
+    QString expiryDate;
+    // SHA-1 of every certificate in the file, bundles included.
+    QList<QByteArray> fingerprints;
+
+    QString keyType;
+    QString keyAlgorithm;
+    int keyLength = 0;
+};
+
+static QMutex metadataMutex;
+static QHash<QString, CertFileInfo> metadataCache;
+
+static void parseCertificate(const QString &path, CertFileInfo *info)
+{
+    QList<QSslCertificate> certificate = QSslCertificate::fromPath(path, QSsl::Pem, QRegExp::FixedString);
+    if (certificate.isEmpty())
+        return;
+
+    QStringList cn = certificate[0].subjectInfo(QSslCertificate::CommonName);
+    QStringList o = certificate[0].subjectInfo(QSslCertificate::Organization);
+    info->commonName = cn.isEmpty() ? QString() : cn[0];
+    info->organization = o.isEmpty() ? QString() : o[0];
+    info->expiryDate = certificate[0].expiryDate().toString("dd.MM.yyyy");
+
+    Q_FOREACH(const QSslCertificate &cert, certificate)
+        info->fingerprints.append(cert.digest(QCryptographicHash::Sha1));
+}
+
+static void parseKey(const QString &path, CertFileInfo *info)
+{
+    QFile keyFile(path);
+    keyFile.open(QIODevice::ReadOnly);
+    QSslKey privateKey( keyFile.readAll(),  QSsl::Rsa );
+
+    if (privateKey.type() == 0){ info->keyType = _("Private key");}
+    else { info->keyType = _("Public key"); }
+
+    if (privateKey.algorithm() == 1) { info->keyAlgorithm = "RSA";}
+    else if (privateKey.algorithm() == 2){ info->keyAlgorithm = "DSA";}
+    else { info->keyAlgorithm = _("Opaque");}
+
+    info->keyLength = privateKey.length();
+}
+
+/* Runs on a worker thread */
+static QList<CertFileInfo> scanDirectory(const QString &path,
+                                         const QStringList &nameFilters,
+                                         void (*parse)(const QString &, CertFileInfo *))
+{
+    QList<CertFileInfo> files;
+    QDir directory(path);
+
+    Q_FOREACH(const QFileInfo &fileInfo,
+              directory.entryInfoList(nameFilters, QDir::Files)) {
+        const QString filePath = fileInfo.absoluteFilePath();
+        {
+            QMutexLocker locker(&metadataMutex);
+            auto it = metadataCache.constFind(filePath);
+            if (it != metadataCache.constEnd()
+                    && it->size == fileInfo.size()
+                    && it->modified == fileInfo.lastModified()) {
+                files.append(*it);
+                continue;
+            }
+        }
+
+        CertFileInfo info;
+        info.fileName = fileInfo.fileName();
+        info.size = fileInfo.size();
+        info.modified = fileInfo.lastModified();
+        parse(filePath, &info);
+
+        QMutexLocker locker(&metadataMutex);
+        metadataCache.insert(filePath, info);
+        files.append(info);
+    }
+
+    std::sort(files.begin(), files.end(),
+              [](const CertFileInfo &a, const CertFileInfo &b) {
+        return QString::compare(a.fileName, b.fileName, Qt::CaseInsensitive) < 0;
+    });
+    return files;
+}
+
+static QList<CertFileInfo> scanCertificates()
+{
+    return scanDirectory(CERTS_PATH, QStringList("*.pem"), parseCertificate);
+}
+
+static QList<CertFileInfo> scanKeys()
+{
+    return scanDirectory(KEYS_PATH, QStringList(), parseKey);
+}
+
+static void watchDirectory(QFileSystemWatcher *watcher, const QString &path)
+{
+    QDir directory(path);
+    if (!directory.exists(path)){
+        directory.mkpath(path);
+    }
+    watcher->addPath(path);
+}
+
+/* A name in directory that is not taken yet, based on name. */
+static QString freeFileName(const QString &directory, QString name,
+                            const QString &suffix)
+{
+    name.replace(" ", "_").replace("/", "_");
+    if (name.isEmpty())
+        name = "certificate";
+
+    QString path = directory + name + suffix;
+    for (int i = 2; QFile::exists(path); i++) {
+        path = directory + name + "_" + QString::number(i) + suffix;
+    }
+    return path;
+}
+
+/* Written to a temporary file first, so readers never see half a file. */
+static bool storeFile(const QString &path, const QByteArray &content)
+{
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning() << "Could not write" << path << ":" << file.errorString();
+        return false;
+    }
+    file.write(content);
+    return file.commit();
+}
+
+/* Runs on a worker thread */
+static FileHandler::ImportResult importCertificates(FileHandler *handler,
+                                                    const QString &filename)
+{
+    FileHandler::ImportResult result;
+
+    QFile file(filename);
+    if (!file.open(QIODevice::ReadOnly)) {
+        qWarning() << "Could not resolve File (" << filename << "): File does not exist or is empty." ;
+        return result;
+    }
+    QByteArray content = file.readAll();
+    QList<QSslCertificate> certificates = QSslCertificate::fromData(content, QSsl::Pem);
+    if (certificates.isEmpty())
+        certificates = QSslCertificate::fromData(content, QSsl::Der);
+    if (certificates.isEmpty()) {
+        qWarning() << filename << "holds no certificate.";
+        return result;
+    }
+
+    QSet<QByteArray> known;
+    Q_FOREACH(const CertFileInfo &info, scanCertificates()) {
+        Q_FOREACH(const QByteArray &fingerprint, info.fingerprints)
+            known.insert(fingerprint);
+    }
+
+    QDir().mkpath(CERTS_PATH);
+    const int total = certificates.size();
+    for (int i = 0; i < total; i++) {
+        const QSslCertificate &certificate = certificates[i];
+        QByteArray fingerprint = certificate.digest(QCryptographicHash::Sha1);
+
+        if (known.contains(fingerprint)) {
+            result.duplicates++;
+        } else {
+            known.insert(fingerprint);
+            QStringList cn = certificate.subjectInfo(QSslCertificate::CommonName);
+            QString path = freeFileName(CERTS_PATH,
+                                        cn.isEmpty() ? QString() : cn[0],
+                                        ".pem");
+            if (!storeFile(path, certificate.toPem()))
+                return result;
+            result.files.append(path);
+        }
+
+        Q_EMIT handler->importProgress(i + 1, total);
+    }
+
+    result.success = true;
+    return result;
+}
+
+/* Runs on a worker thread */
+static FileHandler::ImportResult importKey(FileHandler *handler,
+                                           const QString &filename)
+{
+    FileHandler::ImportResult result;
+
+    QFile file(filename);
+    if (!file.open(QIODevice::ReadOnly)) {
+        qWarning() << "Could not resolve File (" << filename << "): File does not exist or is empty." ;
+        return result;
+    }
+    QByteArray content = file.readAll();
+    QSslKey checkKey(content, QSsl::Rsa);
+    if (checkKey.isNull()) {
+        qWarning() << filename << "holds no RSA key.";
+        return result;
+    }
+
+    QFileInfo fileInfo(file);
+    QString path = KEYS_PATH + fileInfo.fileName().replace(" ", "_");
+    QFile existing(path);
+    if (existing.open(QIODevice::ReadOnly) && existing.readAll() == content) {
+        result.duplicates++;
+    } else {
+        // Saved connections refer to a key by its path, so a different
+        // key of the same name must not replace it.
+        if (existing.exists()) {
+            QString suffix = fileInfo.suffix();
+            path = freeFileName(KEYS_PATH, fileInfo.completeBaseName(),
+                                suffix.isEmpty() ? suffix : "." + suffix);
+        }
+        QDir().mkpath(KEYS_PATH);
+        if (!storeFile(path, content))
+            return result;
+        result.files.append(path);
+    }
+
+    Q_EMIT handler->importProgress(1, 1);
+    result.success = true;
+    return result;
+}
+
+/* Runs on a worker thread */
+static FileHandler::ImportResult importPacFile(FileHandler *handler,
+                                               const QString &filename)
+{
+    FileHandler::ImportResult result;
+
+    QFile file(filename);
+    if (!file.open(QIODevice::ReadOnly)) {
+        qWarning() << "Could not resolve File (" << filename << "): File does not exist or is empty." ;
+        return result;
+    }
+
+    QByteArray content = file.readAll();
+    QFileInfo fileInfo(file);
+    QString path = PACS_PATH + fileInfo.baseName().replace(" ", "_") + ".pac";
+    QFile existing(path);
+    if (existing.open(QIODevice::ReadOnly) && existing.readAll() == content) {
+        result.duplicates++;
+    } else {
+        // Proxy settings refer to a PAC file by its path, so a different
+        // one of the same name must not replace it.
+        if (existing.exists())
+            path = freeFileName(PACS_PATH, fileInfo.baseName(), ".pac");
+        QDir().mkpath(PACS_PATH);
+        if (!storeFile(path, content))
+            return result;
+        result.files.append(path);
+    }
+
+    Q_EMIT handler->importProgress(1, 1);
+    result.success = true;
+    return result;
+}
+
+FileHandler::FileHandler(QObject *parent) : QObject(parent) {
+    connect(&m_import, SIGNAL(finished()), this, SLOT(onImportFinished()));
+}
+
+FileHandler::~FileHandler() {
+    m_import.waitForFinished();
+}
+
+bool FileHandler::importing() const {
+    return m_import.isRunning();
+}
+
+bool FileHandler::importFile(QString filename, int type){
+    if (m_import.isRunning()) {
+        qWarning() << "An import is already running.";
+        return false;
+    }
+
+    switch (type) {
+    case Certificate:
+        m_import.setFuture(QtConcurrent::run(importCertificates, this, filename));
+        break;
+    case PrivateKey:
+        m_import.setFuture(QtConcurrent::run(importKey, this, filename));
+        break;
+    case PacFile:
+        m_import.setFuture(QtConcurrent::run(importPacFile, this, filename));
+        break;
+    default:
+        return false;
+    }
+
+    Q_EMIT importingChanged();
+    return true;
+}
+
+void FileHandler::onImportFinished(){
+    ImportResult result = m_import.result();
+    Q_EMIT importingChanged();
+    Q_EMIT importFinished(result.success, result.files, result.duplicates);
+}
+
+/***************************************/
+
 struct CertificateListModel::Private {
-    QStringList data;
+    QList<CertFileInfo> files;
+    QFutureWatcher<QList<CertFileInfo>> scan;
+    QFileSystemWatcher directory;
+    bool rescan = false;
 };
 
 CertificateListModel::CertificateListModel(QObject *parent) : QAbstractListModel(parent) {
     p = new CertificateListModel::Private();
-    QStringList nameFilter("*.pem");
-    QDir directory(CERTS_PATH);
-    QStringList files = directory.entryList(nameFilter);
-    files.sort(Qt::CaseInsensitive);
-    files.insert(0, _("None") );
-    files.append( _("Choose…") );
-    p->data = files;
+    connect(&p->scan, SIGNAL(finished()), this, SLOT(scanFinished()));
+    connect(&p->directory, SIGNAL(directoryChanged(QString)),
+            this, SLOT(dataupdate()));
+    watchDirectory(&p->directory, CERTS_PATH);
+    dataupdate();
 }
 
 CertificateListModel::~CertificateListModel() {
+    p->scan.waitForFinished();
     delete p;
 }
 
@@ -123,56 +443,61 @@ QHash<int, QByteArray> CertificateListModel::roleNames() const {
 }
 
 int CertificateListModel::rowCount(const QModelIndex &/*parent*/) const {
-    return p->data.size();
+    // "None" and "Choose…" around the files
+    return p->files.size() + 2;
 }
 
 QString CertificateListModel::getfileName(const int selectedIndex) const {
-    return CERTS_PATH + p->data[selectedIndex];
+    if (selectedIndex <= 0 || selectedIndex > p->files.size())
+        return CERTS_PATH + (selectedIndex == 0 ? _("None") : _("Choose…"));
+    return CERTS_PATH + p->files[selectedIndex - 1].fileName;
 }
 
 void CertificateListModel::dataupdate(){
+    if (p->scan.isRunning()) {
+        p->rescan = true;
+        return;
+    }
+    p->scan.setFuture(QtConcurrent::run(scanCertificates));
+}
+
+void CertificateListModel::scanFinished(){
     beginResetModel();
-    p->data.clear();
-    QStringList nameFilter("*.pem");
-    QDir directory(CERTS_PATH);
-    QStringList files = directory.entryList(nameFilter);
-    files.sort(Qt::CaseInsensitive);
-    files.insert(0, _("None") );
-    files.append( _("Choose…") );
-    p->data = files;
+    p->files = p->scan.result();
     endResetModel();
+
+    if (p->rescan) {
+        p->rescan = false;
+        dataupdate();
+    }
 }
 
 QVariant CertificateListModel::data(const QModelIndex &index, int role) const {
-    if(!index.isValid() || index.row() >= ( p->data.size()) ) {
+    if(!index.isValid() || index.row() >= rowCount()) {
         return QVariant();
     } else if (index.row() == 0){
-        const QString &row0 = p->data[index.row()];
-
         switch(role) {
-        case CNRole : return row0;
+        case CNRole : return _("None");
         case ORole : return "";
         case expDateRole : return "";
-
+        default : return QVariant();
         }
-    } else if (index.row() == p->data.size()-1){
-        const QString &rowend = p->data[index.row()];
-
+    } else if (index.row() == rowCount()-1){
         switch(role) {
-        case CNRole : return rowend;
+        case CNRole : return _("Choose…");
         case ORole : return "";
         case expDateRole : return "";
+        default : return QVariant();
         }
     }
 
-    const QString &row = CERTS_PATH+p->data[index.row()];
-    QList<QSslCertificate> certificate = QSslCertificate::fromPath(row, QSsl::Pem, QRegExp::Wildcard);
+    const CertFileInfo &row = p->files[index.row() - 1];
 
     switch(role) {
 
-    case CNRole : return certificate[0].subjectInfo(QSslCertificate::CommonName)[0];
-    case ORole : return certificate[0].subjectInfo(QSslCertificate::Organization)[0];
-    case expDateRole : return certificate[0].expiryDate().toString("dd.MM.yyyy");
+    case CNRole : return row.commonName;
+    case ORole : return row.organization;
+    case expDateRole : return row.expiryDate;
 
     default : return QVariant();
     }
@@ -181,20 +506,23 @@ QVariant CertificateListModel::data(const QModelIndex &index, int role) const {
 /***************************************/
 
 struct PrivatekeyListModel::Private {
-    QStringList data;
+    QList<CertFileInfo> files;
+    QFutureWatcher<QList<CertFileInfo>> scan;
+    QFileSystemWatcher directory;
+    bool rescan = false;
 };
 
 PrivatekeyListModel::PrivatekeyListModel(QObject *parent) : QAbstractListModel(parent) {
     p = new PrivatekeyListModel::Private();
-    QDir directory(KEYS_PATH);
-    QStringList files = directory.entryList(QDir::Files, QDir::Name);
-    files.sort(Qt::CaseInsensitive);
-    files.insert(0, _("None") );
-    files.append( _("Choose…") );
-    p->data = files;
+    connect(&p->scan, SIGNAL(finished()), this, SLOT(scanFinished()));
+    connect(&p->directory, SIGNAL(directoryChanged(QString)),
+            this, SLOT(dataupdate()));
+    watchDirectory(&p->directory, KEYS_PATH);
+    dataupdate();
 }
 
 PrivatekeyListModel::~PrivatekeyListModel() {
+    p->scan.waitForFinished();
     delete p;
 }
 
@@ -208,68 +536,64 @@ QHash<int, QByteArray> PrivatekeyListModel::roleNames() const {
 }
 
 int PrivatekeyListModel::rowCount(const QModelIndex &/*parent*/) const {
-    return p->data.size();
+    // "None" and "Choose…" around the files
+    return p->files.size() + 2;
 }
 
 QString PrivatekeyListModel::getfileName(const int selectedIndex) const {
-    return  KEYS_PATH + p->data[selectedIndex];
+    if (selectedIndex <= 0 || selectedIndex > p->files.size())
+        return KEYS_PATH + (selectedIndex == 0 ? _("None") : _("Choose…"));
+    return KEYS_PATH + p->files[selectedIndex - 1].fileName;
 }
 
 void PrivatekeyListModel::dataupdate(){
+    if (p->scan.isRunning()) {
+        p->rescan = true;
+        return;
+    }
+    p->scan.setFuture(QtConcurrent::run(scanKeys));
+}
+
+void PrivatekeyListModel::scanFinished(){
     beginResetModel();
-    p->data.clear();
-    QDir directory(KEYS_PATH);
-    QStringList files = directory.entryList(QDir::Files, QDir::Name);
-    files.sort(Qt::CaseInsensitive);
-    files.insert(0, _("None") );
-    files.append( _("Choose…") );
-    p->data = files;
+    p->files = p->scan.result();
     endResetModel();
+
+    if (p->rescan) {
+        p->rescan = false;
+        dataupdate();
+    }
 }
 
 QVariant PrivatekeyListModel::data(const QModelIndex &index, int role) const {
-    if(!index.isValid() || index.row() >= ( p->data.size()) ) {
+    if(!index.isValid() || index.row() >= rowCount()) {
         return QVariant();
     } else if (index.row() == 0){
-        const QString &row0 = p->data[index.row()];
-
         switch(role) {
-        case keyName : return row0; // returns "None"
+        case keyName : return _("None");
         case keyType : return "";
         case keyAlgorithm : return "";
         case keyLength : return "";
+        default : return QVariant();
         }
-    } else if (index.row() == p->data.size()-1){
-        const QString &rowend = p->data[index.row()];
-
+    } else if (index.row() == rowCount()-1){
         switch(role) {
-        case keyName : return rowend; // returns "Choose file...
+        case keyName : return _("Choose…");
         case keyType : return "";
         case keyAlgorithm : return "";
         case keyLength : return "";
+        default : return QVariant();
         }
     }
 
-    const QString &row = KEYS_PATH+p->data[index.row()];
-    QFile keyFile(row);
-    keyFile.open(QIODevice::ReadOnly);
-    QSslKey privateKey( keyFile.readAll(),  QSsl::Rsa );
-    QString type;
-    if (privateKey.type() == 0){ type = _("Private key");}
-    else { type = _("Public key"); }
-
-    QString algorithm;
-    if (privateKey.algorithm() == 1) { algorithm = "RSA";}
-    else if (privateKey.algorithm() == 2){ algorithm = "DSA";}
-    else { algorithm = _("Opaque");}
+    const CertFileInfo &row = p->files[index.row() - 1];
 
-    QFileInfo keyFileInfo(keyFile);
     switch(role) {
 
-    case keyName : return keyFileInfo.fileName();
-    case keyType : return type;
-    case keyAlgorithm : return algorithm;
-    case keyLength : return privateKey.length();
+    case keyName : return row.fileName;
+    case keyType : return row.keyType;
+    case keyAlgorithm : return row.keyAlgorithm;
+    case keyLength : return row.keyLength;
 
     default : return QVariant();
     }
@@ -279,10 +603,14 @@ QVariant PrivatekeyListModel::data(const QModelIndex &index, int role) const {
 
 struct PacFileListModel::Private {
     QStringList data;
+    QFileSystemWatcher directory;
 };
 
 PacFileListModel::PacFileListModel(QObject *parent) : QAbstractListModel(parent) {
     p = new PacFileListModel::Private();
+    connect(&p->directory, SIGNAL(directoryChanged(QString)),
+            this, SLOT(dataupdate()));
+    watchDirectory(&p->directory, PACS_PATH);
     QDir directory(PACS_PATH);
     QStringList files = directory.entryList(QDir::Files, QDir::Name);
     files.sort(Qt::CaseInsensitive);
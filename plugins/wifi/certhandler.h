@@ -5,16 +5,51 @@
 #include <QtQml/QQmlContext>
 #include <QObject>
 #include <QAbstractListModel>
+#include <QFutureWatcher>
 
 class FileHandler : public QObject
 {
     Q_OBJECT
+    Q_PROPERTY(bool importing READ importing NOTIFY importingChanged)
 public:
+    enum FileType {
+        Certificate = 0,
+        PrivateKey,
+        PacFile,
+    };
+    Q_ENUMS(FileType)
+
+    struct ImportResult {
+        bool success = false;
+        QStringList files;
+        int duplicates = 0;
+    };
+
+    explicit FileHandler(QObject *parent = 0);
+    ~FileHandler();
+
     Q_INVOKABLE QByteArray getCertContent(QString filename);
     Q_INVOKABLE QString moveCertFile(QString filename);
     Q_INVOKABLE QString moveKeyFile(QString filename);
     Q_INVOKABLE QString movePacFile(QString filename);
     Q_INVOKABLE bool removeFile(QString filename);
+
+    /* Validates and stores filename on a worker thread. Certificate
+       bundles are split into one file per certificate and certificates
+       already stored are skipped. The source file is left alone. */
+    Q_INVOKABLE bool importFile(QString filename, int type);
+    bool importing() const;
+
+Q_SIGNALS:
+    void importingChanged();
+    void importProgress(int done, int total);
+    void importFinished(bool success, const QStringList &files, int duplicates);
+
+private Q_SLOTS:
+    void onImportFinished();
+
+private:
+    QFutureWatcher<ImportResult> m_import;
 };
 
 
@@ -36,9 +71,15 @@ public:
     QHash<int, QByteArray> roleNames() const;
     Q_INVOKABLE int rowCount(const QModelIndex &parent = QModelIndex()) const;
     Q_INVOKABLE QString  getfileName(const int selectedIndex) const;
-    Q_INVOKABLE void dataupdate();
     QVariant data(const QModelIndex &index, int role) const;
 
+public Q_SLOTS:
+    // Not needed any more, the certificate directory is watched.
+    void dataupdate();
+
+private Q_SLOTS:
+    void scanFinished();
+
 private:
     struct Private;
     Private *p;
@@ -62,8 +103,15 @@ public:
     QHash<int, QByteArray> roleNames() const;
     Q_INVOKABLE int rowCount(const QModelIndex &parent = QModelIndex()) const;
     Q_INVOKABLE QString  getfileName(const int selectedIndex) const;
-    Q_INVOKABLE void dataupdate();
     QVariant data(const QModelIndex &index, int role) const;
+
+public Q_SLOTS:
+    // Not needed any more, the key directory is watched.
+    void dataupdate();
+
+private Q_SLOTS:
+    void scanFinished();
+
 private:
     struct Private;
     Private *p;
@@ -85,8 +133,12 @@ public:
     QHash<int, QByteArray> roleNames() const;
     Q_INVOKABLE int rowCount(const QModelIndex &parent = QModelIndex()) const;
     Q_INVOKABLE QString  getfileName(const int selectedIndex) const;
-    Q_INVOKABLE void dataupdate();
     QVariant data(const QModelIndex &index, int role) const;
+
+public Q_SLOTS:
+    // Not needed any more, the PAC file directory is watched.
+    void dataupdate();
+
 private:
     struct Private;
     Private *p;
@@ -0,0 +1,319 @@
+/*
+ * Copyright (C) 2016 Canonical, Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3, as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "networkmanagermirror.h"
+#include <QtDebug>
+#include <arpa/inet.h>
+
+#define NM_SERVICE "org.freedesktop.NetworkManager"
+#define NM_PATH "/org/freedesktop/NetworkManager"
+#define NM_IFACE "org.freedesktop.NetworkManager"
+#define NM_DEVICE_IFACE "org.freedesktop.NetworkManager.Device"
+#define NM_IP4_CONFIG_IFACE "org.freedesktop.NetworkManager.IP4Config"
+#define NM_ACTIVE_CONNECTION_IFACE "org.freedesktop.NetworkManager.Connection.Active"
+#define DBUS_PROPERTIES_IFACE "org.freedesktop.DBus.Properties"
+
+namespace {
+
+const char *interfaceOf(int kind)
+{
+    switch (kind) {
+    case 0: return NM_DEVICE_IFACE;
+    case 1: return NM_IP4_CONFIG_IFACE;
+    default: return NM_ACTIVE_CONNECTION_IFACE;
+    }
+}
+
+QString objectPath(const QVariant &v)
+{
+    QString path = qvariant_cast<QDBusObjectPath>(v).path();
+    return path == "/" ? QString() : path;
+}
+
+QString firstAddress(const QVariantMap &properties)
+{
+    auto data = properties.find("AddressData");
+    if (data != properties.end()) {
+        QList<QVariantMap> addresses;
+        data->value<QDBusArgument>() >> addresses;
+        if (!addresses.isEmpty())
+            return addresses.first().value("address").toString();
+        return QString();
+    }
+
+    // NetworkManager before 1.0 only has the deprecated property.
+    auto legacy = properties.find("Addresses");
+    if (legacy != properties.end()) {
+        QList<QList<uint>> addresses;
+        legacy->value<QDBusArgument>() >> addresses;
+        if (!addresses.isEmpty() && !addresses.first().isEmpty()) {
+            quint32 a = ntohl(addresses.first().first());
+            return QString("%1.%2.%3.%4").arg(a >> 24).arg((a >> 16) & 0xff)
+                                         .arg((a >> 8) & 0xff).arg(a & 0xff);
+        }
+    }
+
+    return QString();
+}
+
+}
+
+NetworkManagerMirror::NetworkManagerMirror(const QDBusConnection &dbus,
+                                           QObject *parent)
+    : QObject(parent)
+    , m_dbus(dbus)
+    , m_pending(0)
+{
+    m_dbus.connect(NM_SERVICE, NM_PATH, NM_IFACE, "DeviceAdded",
+                   this, SLOT(deviceAdded(QDBusObjectPath)));
+    m_dbus.connect(NM_SERVICE, NM_PATH, NM_IFACE, "DeviceRemoved",
+                   this, SLOT(deviceRemoved(QDBusObjectPath)));
+    // One match rule per interface, whatever the number of objects.
+    m_dbus.connect(NM_SERVICE, QString(), NM_DEVICE_IFACE, "PropertiesChanged",
+                   this, SLOT(devicePropertiesChanged(QVariantMap, QDBusMessage)));
+    m_dbus.connect(NM_SERVICE, QString(), NM_IP4_CONFIG_IFACE, "PropertiesChanged",
+                   this, SLOT(ip4ConfigPropertiesChanged(QVariantMap, QDBusMessage)));
+    m_dbus.connect(NM_SERVICE, QString(), NM_ACTIVE_CONNECTION_IFACE, "PropertiesChanged",
+                   this, SLOT(activeConnectionPropertiesChanged(QVariantMap, QDBusMessage)));
+
+    refresh();
+}
+
+QSharedPointer<NetworkManagerMirror> NetworkManagerMirror::shared(const QDBusConnection &dbus)
+{
+    static QHash<QString, QWeakPointer<NetworkManagerMirror>> mirrors;
+
+    QSharedPointer<NetworkManagerMirror> mirror = mirrors.value(dbus.name()).toStrongRef();
+    if (!mirror) {
+        mirror = QSharedPointer<NetworkManagerMirror>(new NetworkManagerMirror(dbus),
+                                                      &QObject::deleteLater);
+        mirrors.insert(dbus.name(), mirror);
+    }
+    return mirror;
+}
+
+bool NetworkManagerMirror::isReady() const
+{
+    return m_pending == 0;
+}
+
+void NetworkManagerMirror::refresh()
+{
+    QDBusMessage msg = QDBusMessage::createMethodCall(NM_SERVICE, NM_PATH,
+                                                      NM_IFACE, "GetDevices");
+    auto watcher = new QDBusPendingCallWatcher(m_dbus.asyncCall(msg), this);
+    QObject::connect(watcher, SIGNAL(finished(QDBusPendingCallWatcher*)),
+                     this, SLOT(devicesListed(QDBusPendingCallWatcher*)));
+    m_pending++;
+}
+
+QStringList NetworkManagerMirror::devices() const
+{
+    return m_order;
+}
+
+NetworkManagerMirror::Device NetworkManagerMirror::device(const QString &path) const
+{
+    return m_devices.value(path);
+}
+
+QString NetworkManagerMirror::wifiDevice() const
+{
+    for (const auto &path : m_order) {
+        if (m_devices.value(path).type == 2 /* NM_DEVICE_TYPE_WIFI */)
+            return path;
+    }
+    return QString();
+}
+
+QString NetworkManagerMirror::ip4Address(const QString &devicePath) const
+{
+    return m_ip4Addresses.value(m_devices.value(devicePath).ip4Config);
+}
+
+QString NetworkManagerMirror::connectionOf(const QString &activeConnectionPath) const
+{
+    return m_activeConnections.value(activeConnectionPath);
+}
+
+void NetworkManagerMirror::devicesListed(QDBusPendingCallWatcher *call)
+{
+    QDBusPendingReply<QList<QDBusObjectPath>> reply = *call;
+    call->deleteLater();
+    m_pending--;
+
+    if (reply.isError()) {
+        qWarning() << "Could not get network devices: " << reply.error().message() << "\n";
+    } else {
+        QStringList listed;
+        for (const auto &d : reply.value()) {
+            listed.append(d.path());
+        }
+        for (const auto &path : m_order) {
+            if (!listed.contains(path))
+                deviceRemoved(QDBusObjectPath(path));
+        }
+        m_order = listed;
+        for (const auto &path : listed) {
+            if (!m_devices.contains(path)) {
+                m_devices.insert(path, Device());
+                fetch(DeviceObject, path);
+            }
+        }
+    }
+
+    checkReady();
+}
+
+void NetworkManagerMirror::fetch(Kind kind, const QString &path)
+{
+    QDBusMessage msg = QDBusMessage::createMethodCall(NM_SERVICE, path,
+                                                      DBUS_PROPERTIES_IFACE,
+                                                      "GetAll");
+    msg << QString(interfaceOf(kind));
+    auto watcher = new QDBusPendingCallWatcher(m_dbus.asyncCall(msg), this);
+    watcher->setProperty("path", path);
+    watcher->setProperty("kind", int(kind));
+    QObject::connect(watcher, SIGNAL(finished(QDBusPendingCallWatcher*)),
+                     this, SLOT(propertiesFetched(QDBusPendingCallWatcher*)));
+    m_pending++;
+}
+
+void NetworkManagerMirror::propertiesFetched(QDBusPendingCallWatcher *call)
+{
+    QDBusPendingReply<QVariantMap> reply = *call;
+    QString path = call->property("path").toString();
+    int kind = call->property("kind").toInt();
+    call->deleteLater();
+    m_pending--;
+
+    if (reply.isError()) {
+        // Most likely the object went away in the meantime.
+        qWarning() << "Could not get properties of" << path << ":"
+                   << reply.error().message();
+    } else if (kind == DeviceObject) {
+        applyDevice(path, reply.value());
+    } else if (kind == Ip4ConfigObject) {
+        applyIp4Config(path, reply.value());
+    } else {
+        applyActiveConnection(path, reply.value());
+    }
+
+    checkReady();
+}
+
+void NetworkManagerMirror::applyDevice(const QString &path, const QVariantMap &properties)
+{
+    auto it = m_devices.find(path);
+    if (it == m_devices.end())
+        return;
+
+    if (properties.contains("DeviceType"))
+        it->type = properties.value("DeviceType").toUInt();
+    if (properties.contains("State"))
+        it->state = properties.value("State").toUInt();
+    if (properties.contains("IpInterface"))
+        it->ipInterface = properties.value("IpInterface").toString();
+
+    if (properties.contains("Ip4Config")) {
+        QString config = objectPath(properties.value("Ip4Config"));
+        if (config != it->ip4Config) {
+            m_ip4Addresses.remove(it->ip4Config);
+            it->ip4Config = config;
+            if (!config.isEmpty())
+                fetch(Ip4ConfigObject, config);
+        }
+    }
+
+    if (properties.contains("ActiveConnection")) {
+        QString active = objectPath(properties.value("ActiveConnection"));
+        if (active != it->activeConnection) {
+            m_activeConnections.remove(it->activeConnection);
+            it->activeConnection = active;
+            if (!active.isEmpty())
+                fetch(ActiveConnectionObject, active);
+        }
+    }
+
+    Q_EMIT changed();
+}
+
+void NetworkManagerMirror::applyIp4Config(const QString &path, const QVariantMap &properties)
+{
+    if (!properties.contains("AddressData") && !properties.contains("Addresses"))
+        return;
+
+    m_ip4Addresses.insert(path, firstAddress(properties));
+    Q_EMIT changed();
+}
+
+void NetworkManagerMirror::applyActiveConnection(const QString &path, const QVariantMap &properties)
+{
+    if (!properties.contains("Connection"))
+        return;
+
+    m_activeConnections.insert(path, objectPath(properties.value("Connection")));
+    Q_EMIT changed();
+}
+
+void NetworkManagerMirror::checkReady()
+{
+    if (isReady())
+        Q_EMIT ready();
+}
+
+void NetworkManagerMirror::deviceAdded(const QDBusObjectPath &path)
+{
+    if (m_devices.contains(path.path()))
+        return;
+
+    m_order.append(path.path());
+    m_devices.insert(path.path(), Device());
+    fetch(DeviceObject, path.path());
+}
+
+void NetworkManagerMirror::deviceRemoved(const QDBusObjectPath &path)
+{
+    auto it = m_devices.find(path.path());
+    if (it == m_devices.end())
+        return;
+
+    m_ip4Addresses.remove(it->ip4Config);
+    m_activeConnections.remove(it->activeConnection);
+    m_devices.erase(it);
+    m_order.removeAll(path.path());
+    Q_EMIT changed();
+}
+
+void NetworkManagerMirror::devicePropertiesChanged(const QVariantMap &properties,
+                                                   const QDBusMessage &message)
+{
+    applyDevice(message.path(), properties);
+}
+
+void NetworkManagerMirror::ip4ConfigPropertiesChanged(const QVariantMap &properties,
+                                                      const QDBusMessage &message)
+{
+    if (m_ip4Addresses.contains(message.path()))
+        applyIp4Config(message.path(), properties);
+}
+
+void NetworkManagerMirror::activeConnectionPropertiesChanged(const QVariantMap &properties,
+                                                             const QDBusMessage &message)
+{
+    if (m_activeConnections.contains(message.path()))
+        applyActiveConnection(message.path(), properties);
+}
@@ -0,0 +1,107 @@
+/*
+ * Copyright (C) 2016 Canonical, Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3, as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef NETWORK_MANAGER_MIRROR_H
+#define NETWORK_MANAGER_MIRROR_H
+
+#include <QHash>
+#include <QObject>
+#include <QSharedPointer>
+#include <QStringList>
+#include <QtDBus>
+
+/**
+ * In-memory copy of NetworkManager's devices, their IPv4 configurations
+ * and active connections.
+ *
+ * It is filled asynchronously (GetDevices, then one GetAll per object, all
+ * in flight together) and kept current from DeviceAdded/DeviceRemoved and
+ * the PropertiesChanged signals, so that queries never block on the bus.
+ */
+class NetworkManagerMirror final : public QObject {
+    Q_OBJECT
+
+public:
+    struct Device {
+        uint type = 0;
+        uint state = 0;
+        QString ipInterface;
+        QString ip4Config;
+        QString activeConnection;
+    };
+
+    explicit NetworkManagerMirror(const QDBusConnection &dbus,
+                                  QObject *parent = nullptr);
+    ~NetworkManagerMirror() {};
+
+    /* The mirror of dbus's NetworkManager that everyone in the process
+       holding one shares, so that each object is fetched and watched
+       once. */
+    static QSharedPointer<NetworkManagerMirror> shared(const QDBusConnection &dbus);
+
+    /* False while any object is still being fetched. */
+    bool isReady() const;
+    /* Lists the devices again, for callers that cannot wait for signals. */
+    void refresh();
+
+    QStringList devices() const;
+    Device device(const QString &path) const;
+    /* The first wifi device, in NetworkManager's order. */
+    QString wifiDevice() const;
+    /* The first IPv4 address of the device, or an empty string. */
+    QString ip4Address(const QString &devicePath) const;
+    /* The settings connection behind an active connection. */
+    QString connectionOf(const QString &activeConnectionPath) const;
+
+Q_SIGNALS:
+    // Emitted each time the last pending fetch completes.
+    void ready();
+    void changed();
+
+private Q_SLOTS:
+    void devicesListed(QDBusPendingCallWatcher *call);
+    void propertiesFetched(QDBusPendingCallWatcher *call);
+    void deviceAdded(const QDBusObjectPath &path);
+    void deviceRemoved(const QDBusObjectPath &path);
+    void devicePropertiesChanged(const QVariantMap &properties,
+                                 const QDBusMessage &message);
+    void ip4ConfigPropertiesChanged(const QVariantMap &properties,
+                                    const QDBusMessage &message);
+    void activeConnectionPropertiesChanged(const QVariantMap &properties,
+                                           const QDBusMessage &message);
+
+private:
+    enum Kind {
+        DeviceObject,
+        Ip4ConfigObject,
+        ActiveConnectionObject
+    };
+
+    void fetch(Kind kind, const QString &path);
+    void applyDevice(const QString &path, const QVariantMap &properties);
+    void applyIp4Config(const QString &path, const QVariantMap &properties);
+    void applyActiveConnection(const QString &path, const QVariantMap &properties);
+    void checkReady();
+
+    QDBusConnection m_dbus;
+    QStringList m_order;
+    QHash<QString, Device> m_devices;
+    QHash<QString, QString> m_ip4Addresses;
+    QHash<QString, QString> m_activeConnections;
+    int m_pending;
+};
+
+#endif
@@ -20,6 +20,7 @@
 #include <QtQml>
 #include <QtQml/QQmlContext>
 #include "unitymenumodelstack.h"
+#include "accesspointmodel.h"
 #include "wifidbushelper.h"
 #include "previousnetworkmodel.h"
 #include "certhandler.h"
@@ -46,6 +47,7 @@ void BackendPlugin::registerTypes(const char *uri)
     qmlRegisterType<UnityMenuModelStack>(uri, 1, 0, "UnityMenuModelStack");
     qmlRegisterSingletonType<WifiDbusHelper>(uri, 1, 0, "DbusHelper", dbusProvider);
     qmlRegisterType<PreviousNetworkModel>(uri, 1, 0, "PreviousNetworkModel");
+    qmlRegisterType<AccessPointModel>(uri, 1, 0, "AccessPointModel");
     qmlRegisterType<CertificateListModel>(uri, 1, 0, "CertificateListModel");
     qmlRegisterType<PrivatekeyListModel>(uri, 1, 0, "PrivatekeyListModel");
     qmlRegisterType<PacFileListModel>(uri, 1, 0, "PacFileListModel");
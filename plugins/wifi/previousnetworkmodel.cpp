@@ -16,59 +16,265 @@
  * You should have received a copy of the GNU General Public License
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
-
 #include "previousnetworkmodel.h"
-#include "wifidbushelper.h"
+#include "nm_settings_proxy.h"
+#include "nm_settings_connection_proxy.h"
+
+#include <QDateTime>
+#include <QLocale>
+#include <QtDebug>
+#include <algorithm>
+
+typedef QMap<QString,QVariantMap> ConfigurationData;
 
+const QString nm_service("org.freedesktop.NetworkManager");
+const QString nm_settings_path("/org/freedesktop/NetworkManager/Settings");
+const QString nm_settings("org.freedesktop.NetworkManager.Settings");
+const QString nm_settings_new_connection_member("NewConnection");
+const QString nm_settings_connection_removed("ConnectionRemoved");
 const QString nm_settings_connection("org.freedesktop.NetworkManager.Settings.Connection");
 const QString nm_settings_connection_removed_member("Removed");
+const QString nm_settings_connection_updated_member("Updated");
+
+namespace {
+
+struct Network {
+    QString name;
+    QString path;
+    QString lastUsed;
+    // Rows are sorted by sortKey, then by path.
+    QString sortKey;
+};
+
+/* Only wireless connections are listed, and only their settings are
+   looked at: secrets are fetched when the details page asks for them. */
+bool parseNetwork(const QString &path, const ConfigurationData &settings,
+                  Network *network)
+{
+    if (!settings.contains("connection"))
+        return false;
+
+    auto connection = settings["connection"];
+    if (connection["type"].toString() != "802-11-wireless")
+        return false;
+
+    if (!settings.contains("802-11-wireless"))
+        return false;
+
+    auto wireless = settings["802-11-wireless"];
+    auto match = wireless.find("security");
+    if (match != wireless.end() && *match != "802-11-wireless-security")
+        return false;
+
+    network->name = connection["id"].toString();
+    network->path = path;
+    network->sortKey = network->name.toLower();
+
+    qulonglong timestamp = connection.value("timestamp").toULongLong();
+    if (timestamp != 0) {
+        QLocale locale;
+        network->lastUsed = locale.toString(
+            QDateTime::fromMSecsSinceEpoch(timestamp*1000), locale.dateFormat());
+    }
+
+    return true;
+}
+
+bool lessThan(const Network &a, const Network &b)
+{
+    if (a.sortKey != b.sortKey)
+        return a.sortKey < b.sortKey;
+    return a.path < b.path;
+}
+
+}
 
 struct PreviousNetworkModel::Private {
-    QList<QStringList> data;
+    QHash<QString, Network> networks;
+    // Object paths in row order.
+    QStringList rows;
+    // Settings calls in flight per connection, only the last reply counts.
+    QHash<QString, int> fetching;
+
+    int findRow(const Network &network) const
+    {
+        int row = insertionRow(network);
+        return (row < rows.size() && rows[row] == network.path) ? row : -1;
+    }
+
+    int insertionRow(const Network &network) const
+    {
+        auto it = std::lower_bound(rows.begin(), rows.end(), network,
+            [this](const QString &path, const Network &n) {
+                return lessThan(*networks.constFind(path), n);
+            });
+        return it - rows.begin();
+    }
 };
 
 PreviousNetworkModel::PreviousNetworkModel(QObject *parent) : QAbstractListModel(parent) {
     p = new PreviousNetworkModel::Private();
 
+    qDBusRegisterMetaType<ConfigurationData>();
+
     const QString service("");
     const QString path("");
 
-    QDBusConnection::systemBus().connect(
+    auto bus = QDBusConnection::systemBus();
+    bus.connect(
+        nm_service,
+        nm_settings_path,
+        nm_settings,
+        nm_settings_new_connection_member,
+        this,
+        SLOT(connectionAdded(QDBusObjectPath)));
+    bus.connect(
+        nm_service,
+        nm_settings_path,
+        nm_settings,
+        nm_settings_connection_removed,
+        this,
+        SLOT(connectionRemoved(QDBusObjectPath)));
+    // Older NetworkManager only signals removal on the connection itself.
+    bus.connect(
         service,
         path,
         nm_settings_connection,
         nm_settings_connection_removed_member,
         this,
-        SLOT(removeConnection()));
+        SLOT(connectionRemoved(QDBusMessage)));
+    bus.connect(
+        service,
+        path,
+        nm_settings_connection,
+        nm_settings_connection_updated_member,
+        this,
+        SLOT(connectionUpdated(QDBusMessage)));
 
-    WifiDbusHelper h;
-    auto networks = h.getPreviouslyConnectedWifiNetworks();
-    p->data = networks;
+    OrgFreedesktopNetworkManagerSettingsInterface settings
+            (nm_service,
+             nm_settings_path,
+             bus);
+    auto watcher = new QDBusPendingCallWatcher(settings.ListConnections(), this);
+    connect(watcher, SIGNAL(finished(QDBusPendingCallWatcher*)),
+            this, SLOT(connectionsListed(QDBusPendingCallWatcher*)));
+}
 
+void PreviousNetworkModel::connectionsListed(QDBusPendingCallWatcher *call)
+{
+    QDBusPendingReply<QList<QDBusObjectPath>> reply = *call;
+    call->deleteLater();
+
+    if (reply.isError()) {
+        qWarning() << "ERROR " << reply.error().message() << "\n";
+        return;
+    }
+
+    // All requests go out at once and rows appear as replies complete.
+    for (const auto &c : reply.value()) {
+        if (!p->networks.contains(c.path()))
+            fetch(c.path());
+    }
 }
 
-void PreviousNetworkModel::removeConnection()
+void PreviousNetworkModel::fetch(const QString &path)
 {
-    WifiDbusHelper h;
-    QList<QStringList> networks = h.getPreviouslyConnectedWifiNetworks();
-
-    int row = -1;
-    for (int i=0, n=p->data.length(); row==-1 && i<n; i++) {
-        if (i > networks.length() - 1) {
-            row = i;
-            break;
-        }
-        if (networks[i][1] != p->data.at(i)[1]) {
-            row = i;
-            break;
-        }
+    OrgFreedesktopNetworkManagerSettingsConnectionInterface conn
+            (nm_service,
+             path,
+             QDBusConnection::systemBus());
+    auto watcher = new QDBusPendingCallWatcher(conn.GetSettings(), this);
+    watcher->setProperty("path", path);
+    connect(watcher, SIGNAL(finished(QDBusPendingCallWatcher*)),
+            this, SLOT(settingsFetched(QDBusPendingCallWatcher*)));
+    p->fetching[path]++;
+}
+
+void PreviousNetworkModel::settingsFetched(QDBusPendingCallWatcher *call)
+{
+    QDBusPendingReply<ConfigurationData> reply = *call;
+    QString path = call->property("path").toString();
+    call->deleteLater();
+
+    // Removed while the call was in flight, or superseded by a newer one.
+    auto pending = p->fetching.find(path);
+    if (pending == p->fetching.end() || --*pending > 0)
+        return;
+    p->fetching.erase(pending);
+
+    Network network;
+    if (reply.isError()) {
+        qWarning() << "Error getting network info: " << reply.error().message() << "\n";
+        return;
+    }
+    if (!parseNetwork(path, reply.value(), &network)) {
+        // An update may have turned it into something we do not list.
+        remove(path);
+        return;
+    }
+
+    auto it = p->networks.find(path);
+    if (it == p->networks.end()) {
+        int row = p->insertionRow(network);
+        beginInsertRows(QModelIndex(), row, row);
+        p->networks.insert(path, network);
+        p->rows.insert(row, path);
+        endInsertRows();
+        return;
     }
 
-    if (0<=row && row<p->data.size()) {
-        beginRemoveRows(QModelIndex(), row, row);
-        p->data.removeAt(row);
-        endRemoveRows();
+    int row = p->findRow(*it);
+    if (it->sortKey != network.sortKey) {
+        p->rows.removeAt(row);
+        int target = p->insertionRow(network);
+        p->rows.insert(row, path);
+        if (target != row) {
+            beginMoveRows(QModelIndex(), row, row, QModelIndex(),
+                          target > row ? target + 1 : target);
+            p->rows.move(row, target);
+            endMoveRows();
+            row = target;
+        }
     }
+
+    *it = network;
+    QModelIndex changed = index(row, 0);
+    Q_EMIT dataChanged(changed, changed);
+}
+
+void PreviousNetworkModel::connectionAdded(const QDBusObjectPath &path)
+{
+    fetch(path.path());
+}
+
+void PreviousNetworkModel::connectionRemoved(const QDBusObjectPath &path)
+{
+    remove(path.path());
+}
+
+void PreviousNetworkModel::connectionRemoved(const QDBusMessage &message)
+{
+    remove(message.path());
+}
+
+void PreviousNetworkModel::connectionUpdated(const QDBusMessage &message)
+{
+    fetch(message.path());
+}
+
+void PreviousNetworkModel::remove(const QString &path)
+{
+    p->fetching.remove(path);
+
+    auto it = p->networks.find(path);
+    if (it == p->networks.end())
+        return;
+
+    int row = p->findRow(*it);
+    beginRemoveRows(QModelIndex(), row, row);
+    p->rows.removeAt(row);
+    p->networks.erase(it);
+    endRemoveRows();
 }
 
 PreviousNetworkModel::~PreviousNetworkModel() {
@@ -79,28 +285,26 @@ QHash<int, QByteArray> PreviousNetworkModel::roleNames() const {
     QHash<int, QByteArray> roles;
     roles[NameRole] = "name";
     roles[ObjectPathRole] = "objectPath";
-    roles[PasswordRole] = "password";
     roles[LastUsedRole] = "lastUsed";
     return roles;
 }
 
 int PreviousNetworkModel::rowCount(const QModelIndex &/*parent*/) const {
-    return p->data.size();
+    return p->rows.size();
 }
 
 QVariant PreviousNetworkModel::data(const QModelIndex & index, int role) const {
-    if(!index.isValid() || index.row() >= p->data.size()) {
+    if(!index.isValid() || index.row() >= p->rows.size()) {
         return QVariant();
     }
 
-    const auto &row = p->data[index.row()];
+    const auto &row = p->networks[p->rows[index.row()]];
 
     switch(role) {
 
-    case NameRole : return QVariant(row[0]);
-    case ObjectPathRole : return QVariant(row[1]);
-    case PasswordRole : return QVariant(row[2]);
-    case LastUsedRole : return QVariant(row[3]);
+    case NameRole : return QVariant(row.name);
+    case ObjectPathRole : return QVariant(row.path);
+    case LastUsedRole : return QVariant(row.lastUsed);
 
     default : return QVariant();
 
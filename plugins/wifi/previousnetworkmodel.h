@@ -33,7 +33,6 @@ public:
     enum PreviousNetworkRoles {
         NameRole = Qt::UserRole + 1,
         ObjectPathRole,
-        PasswordRole,
         LastUsedRole,
     };
 
@@ -43,10 +42,18 @@ public:
     int rowCount(const QModelIndex &parent) const;
     QVariant data(const QModelIndex & index, int role) const;
 
-public Q_SLOTS:
-    void removeConnection();
+private Q_SLOTS:
+    void connectionsListed(QDBusPendingCallWatcher *call);
+    void settingsFetched(QDBusPendingCallWatcher *call);
+    void connectionAdded(const QDBusObjectPath &path);
+    void connectionRemoved(const QDBusObjectPath &path);
+    void connectionRemoved(const QDBusMessage &message);
+    void connectionUpdated(const QDBusMessage &message);
 
 private:
+    void fetch(const QString &path);
+    void remove(const QString &path);
+
     struct Private;
     Private *p;
 };
@@ -21,14 +21,13 @@
 #include <QStringList>
 #include <QDBusReply>
 #include <QtDebug>
-#include <QDBusInterface>
-#include <QNetworkInterface>
-#include <algorithm>
 #include <arpa/inet.h>
 
 #include "nm_manager_proxy.h"
 #include "nm_settings_proxy.h"
 #include "nm_settings_connection_proxy.h"
+#include "accesspointindex.h"
+#include "networkmanagermirror.h"
 
 #define NM_SERVICE "org.freedesktop.NetworkManager"
 #define NM_PATH "/org/freedesktop/NetworkManager"
@@ -36,6 +35,7 @@
 #define NM_DEVICE_IFACE "org.freedesktop.NetworkManager.Device"
 #define NM_DEVICE_WIRELESS_IFACE "org.freedesktop.NetworkManager.Device.Wireless"
 #define NM_ACTIVE_CONNECTION_IFACE "org.freedesktop.NetworkManager.Connection.Active"
+#define DBUS_PROPERTIES_IFACE "org.freedesktop.DBus.Properties"
 
 typedef QMap<QString,QVariantMap> ConfigurationData;
 Q_DECLARE_METATYPE(ConfigurationData)
@@ -48,8 +48,19 @@ WifiDbusHelper::WifiDbusHelper(QObject *parent)
 WifiDbusHelper::WifiDbusHelper(const QDBusConnection &dbus, QObject *parent)
     : QObject(parent)
     , m_systemBusConnection(dbus)
+    , m_mirror(NetworkManagerMirror::shared(dbus))
+    , m_activationsInFlight(0)
+    , m_forgetActivations(false)
+    , m_forgetWhenReady(false)
 {
     qDBusRegisterMetaType<ConfigurationData>();
+
+    QObject::connect(m_mirror.data(), SIGNAL(ready()),
+                     this, SLOT(processPendingConnects()));
+    QObject::connect(m_mirror.data(), SIGNAL(ready()),
+                     this, SLOT(processPendingForget()));
+    QObject::connect(m_mirror.data(), SIGNAL(changed()),
+                     this, SLOT(mirrorChanged()));
 }
 
 void WifiDbusHelper::connect(QString ssid, int security, int auth, QStringList usernames, QStringList password, QStringList certs, int p2auth)
@@ -59,10 +70,6 @@ void WifiDbusHelper::connect(QString ssid, int security, int auth, QStringList u
         return;
     }
 
-    OrgFreedesktopNetworkManagerInterface mgr(NM_SERVICE,
-                                              NM_PATH,
-                                              m_systemBusConnection);
-
     QMap<QString, QVariantMap> configuration;
 
     QVariantMap connection;
@@ -185,76 +192,47 @@ void WifiDbusHelper::connect(QString ssid, int security, int auth, QStringList u
         configuration["802-1x"] = wireless_802_1x;
     }
 
-    // find the first wlan adapter for now
-    auto reply1 = mgr.GetDevices();
-    reply1.waitForFinished();
-    if(!reply1.isValid()) {
-        qWarning() << "Could not get network device: " << reply1.error().message() << "\n";
-        return;
-    }
-    auto devices = reply1.value();
-
-    QDBusObjectPath dev;
-    QDBusObjectPath access_point("/");
-    for (const auto &d : devices) {
-        QDBusInterface iface(NM_SERVICE,
-                             d.path(),
-                             NM_DEVICE_IFACE,
-                             m_systemBusConnection);
-
-        auto type_v = iface.property("DeviceType");
-        if (type_v.toUInt() == 2 /* NM_DEVICE_TYPE_WIFI */) {
-
-            // We found the device we want to connect.
-            dev = d;
-
-            // Create a proxy for Device.Wireless.
-            QDBusInterface wiface(NM_SERVICE,
-                                  d.path(),
-                                  NM_DEVICE_WIRELESS_IFACE,
-                                  m_systemBusConnection);
-
-            // Get a list of access points and use ssid to find the
-            // one we're trying to connect to.
-            QDBusMessage ap_msg = wiface.call("GetAllAccessPoints");
-            if (ap_msg.type() == QDBusMessage::ReplyMessage && ap_msg.arguments().count() == 1) {
-
-                // Get arguments.
-                QList<QVariant> ap_variant = ap_msg.arguments();
-
-                // Cast the first QVariant argument as QDBusArgument.
-                QDBusArgument ap_argument = ap_variant.at(0).value<QDBusArgument>();
-
-                // Cast the argument to a list of DBus object paths.
-                QList<QDBusObjectPath> ap_list = qdbus_cast<QList<QDBusObjectPath>>(ap_argument);
-
-                // Loop through the list of paths looking for our ssid.
-                for(int i=0; i<ap_list.size(); ++i){
-
-                    // Proxy for AccessPoint.
-                    QDBusInterface aiface(NM_SERVICE,
-                                          ap_list[i].path(),
-                                          NM_AP_IFACE,
-                                          m_systemBusConnection);
-
-                    auto ssid_v = aiface.property("Ssid");
-
-                    if (QString::compare(ssid.toLatin1(), ssid_v.toString(), Qt::CaseSensitive) == 0) {
-                        access_point = ap_list[i];
-                        break;
-                    }
-                }
-            }
-            break;
-        }
+    ConnectRequest request;
+    request.ssid = ssid.toLatin1();
+    request.configuration = configuration;
+    m_pendingConnects.append(request);
+
+    if (m_mirror->isReady() && m_mirror->wifiDevice().isEmpty()) {
+        // The device may have appeared after the mirror was filled.
+        m_mirror->refresh();
+    } else {
+        processPendingConnects();
     }
+}
 
-    if (dev.path().isEmpty()) {
+void WifiDbusHelper::processPendingConnects()
+{
+    if (m_pendingConnects.isEmpty() || !m_mirror->isReady())
+        return;
+
+    QString wifiDevice = m_mirror->wifiDevice();
+    if (wifiDevice.isEmpty()) {
         // didn't find a wifi device
         qWarning() << "Could not find wifi device.";
+        failPendingConnects("Could not find wifi device.");
         return;
     }
 
+    if (!m_apIndex || m_apIndex->devicePath() != wifiDevice) {
+        if (m_apIndex)
+            QObject::disconnect(m_apIndex.data(), nullptr, this, nullptr);
+        m_apIndex = AccessPointIndex::shared(m_systemBusConnection, wifiDevice);
+        QObject::connect(m_apIndex.data(), SIGNAL(ready()),
+                         this, SLOT(processPendingConnects()));
+    }
+    if (!m_apIndex->isReady())
+        return;
+
+    OrgFreedesktopNetworkManagerInterface mgr(NM_SERVICE,
+                                              NM_PATH,
+                                              m_systemBusConnection);
+    QDBusObjectPath dev(m_apIndex->devicePath());
+
     mgr.connection().disconnect(
         mgr.service(),
         dev.path(),
@@ -271,13 +249,53 @@ void WifiDbusHelper::connect(QString ssid, int security, int auth, QStringList u
         this,
         SLOT(nmDeviceStateChanged(uint, uint, uint)));
 
-    QDBusObjectPath tmp;
-    auto reply2 = mgr.AddAndActivateConnection(configuration,
-                                               dev,
-                                               access_point,
-                                               tmp);
-    if(!reply2.isValid()) {
-        qWarning() << "Could not connect: " << reply2.error().message() << "\n";
+    const auto requests = m_pendingConnects;
+    m_pendingConnects.clear();
+
+    for (const auto &request : requests) {
+        QList<QVariant> argumentList;
+        argumentList << QVariant::fromValue(request.configuration)
+                     << QVariant::fromValue(dev)
+                     << QVariant::fromValue(m_apIndex->find(request.ssid));
+        auto call = mgr.asyncCallWithArgumentList(QStringLiteral("AddAndActivateConnection"),
+                                                  argumentList);
+        auto watcher = new QDBusPendingCallWatcher(call, this);
+        QObject::connect(watcher, SIGNAL(finished(QDBusPendingCallWatcher*)),
+                         this, SLOT(connectionActivated(QDBusPendingCallWatcher*)));
+        m_activationsInFlight++;
+    }
+}
+
+void WifiDbusHelper::connectionActivated(QDBusPendingCallWatcher *call)
+{
+    QDBusPendingReply<QDBusObjectPath, QDBusObjectPath> reply = *call;
+    call->deleteLater();
+    m_activationsInFlight--;
+
+    if (reply.isError()) {
+        qWarning() << "Could not connect: " << reply.error().message() << "\n";
+        Q_EMIT connectFinished(false, reply.error().message());
+    } else {
+        QString connection = reply.argumentAt<0>().path();
+        if (m_forgetActivations) {
+            // Cancelled while NetworkManager was still answering.
+            forgetConnection(connection);
+        } else {
+            m_activatedConnection = connection;
+        }
+        Q_EMIT connectFinished(true, QString());
+    }
+
+    if (m_activationsInFlight == 0)
+        m_forgetActivations = false;
+}
+
+void WifiDbusHelper::failPendingConnects(const QString &error)
+{
+    const int count = m_pendingConnects.size();
+    m_pendingConnects.clear();
+    for (int i = 0; i < count; i++) {
+        Q_EMIT connectFinished(false, error);
     }
 }
 
@@ -287,239 +305,107 @@ void WifiDbusHelper::nmDeviceStateChanged(uint newState,
                                          uint reason)
 {
     Q_UNUSED (oldState);
+
+    // The connection made it; forgetting the active device from now on
+    // means whatever is active then.
+    if (newState == 100) // NM_DEVICE_STATE_ACTIVATED
+        m_activatedConnection.clear();
+
     Q_EMIT (deviceStateChanged(newState, reason));
 }
 
 QString WifiDbusHelper::getWifiIpAddress()
 {
-    OrgFreedesktopNetworkManagerInterface mgr(NM_SERVICE,
-                                              NM_PATH,
-                                              m_systemBusConnection);
+    m_wifiIp4Address = m_mirror->ip4Address(m_mirror->wifiDevice());
+    return m_wifiIp4Address;
+}
 
-    // find the first wlan adapter for now
-    auto reply1 = mgr.GetDevices();
-    reply1.waitForFinished();
-    if(!reply1.isValid()) {
-        qWarning() << "Could not get network device: " << reply1.error().message() << "\n";
-        return QString();
-    }
-    auto devices = reply1.value();
-
-    for (const auto &d : devices) {
-        QDBusInterface iface(NM_SERVICE, d.path(), NM_DEVICE_IFACE, m_systemBusConnection);
-        auto type_v = iface.property("DeviceType");
-        if (type_v.toUInt() == 2 /* NM_DEVICE_TYPE_WIFI */) {
-            auto ip4name = iface.property("IpInterface").toString();
-
-            QList<QNetworkAddressEntry> entries =
-                QNetworkInterface::interfaceFromName(ip4name).addressEntries();
-            if (entries.size() > 0) {
-                return entries[0].ip().toString();
-            }
-            break;
-        }
+void WifiDbusHelper::mirrorChanged()
+{
+    QString address = m_mirror->ip4Address(m_mirror->wifiDevice());
+    if (address != m_wifiIp4Address) {
+        m_wifiIp4Address = address;
+        Q_EMIT wifiIp4AddressChanged(address);
     }
-
-    return QString();
 }
 
-struct Network : public QObject
+void WifiDbusHelper::fetchPassword(const QString dbus_path)
 {
-    struct DontCare : public std::exception {};
-
-    QString id;
-
-    enum class Mode {
-        infrastructure,
-        adhoc,
-        unknown
-    };
-    Mode mode;
-
-    enum class Type {
-        wireless,
-        other
-    };
-    Type type;
-
-    qulonglong timestamp;
-
-    bool isValid;
-    QString path;
-
-    enum class Security
-    {
-        open,
-        secured
-    };
-    Security security;
-    QString password;
-
-    void parseConnection()
-    {
-        if (!settings.contains("connection"))
-            throw DontCare();
-
-        auto connection = settings["connection"];
-        id = connection["id"].toString();
-
-        // we only care about wifi
-        auto type_str = connection["type"].toString();
-        if (type_str != "802-11-wireless")
-            throw DontCare();
-        type = Type::wireless;
+    OrgFreedesktopNetworkManagerSettingsConnectionInterface conn
+            (NM_SERVICE,
+             dbus_path,
+             m_systemBusConnection);
+    auto watcher = new QDBusPendingCallWatcher(conn.GetSettings(), this);
+    watcher->setProperty("path", dbus_path);
+    QObject::connect(watcher, SIGNAL(finished(QDBusPendingCallWatcher*)),
+                     this, SLOT(passwordSettingsFetched(QDBusPendingCallWatcher*)));
+}
 
-        auto match = connection.find("timestamp");
-        if (match == connection.end()) {
-            timestamp = 0;
-        } else {
-            timestamp = (*match).toULongLong();
-        }
-    }
+void WifiDbusHelper::passwordSettingsFetched(QDBusPendingCallWatcher *call)
+{
+    QDBusPendingReply<ConfigurationData> reply = *call;
+    QString path = call->property("path").toString();
+    call->deleteLater();
 
-    void parseWireless()
-    {
-        if (!settings.contains("802-11-wireless"))
-            throw DontCare();
-
-        auto wireless = settings["802-11-wireless"];
-
-        auto mode_str = wireless["mode"];
-        if (mode_str == "infrastructure")
-            mode = Mode::infrastructure;
-        else if (mode_str == "adhoc")
-            mode = Mode::adhoc;
-        else
-            mode = Mode::unknown;
-
-        auto match = wireless.find("security");
-        if (match != wireless.end())
-        {
-            auto security_str = *match;
-            if (security_str != "802-11-wireless-security")
-                throw DontCare();
-            security = Security::secured;
-            parseWirelessSecurity();
-        } else {
-            security = Security::open;
-        }
+    if (reply.isError()) {
+        qWarning() << "Error getting network info: " << reply.error().message() << "\n";
+        Q_EMIT passwordFetched(path, QString());
+        return;
     }
 
-    void parseWirelessSecurity()
-    {
-        if (!settings.contains("802-11-wireless-security"))
-            return;
-
-        auto security = settings["802-11-wireless-security"];
-        auto keymgmt = security["key-mgmt"];
-        auto authalg = security["auth-alg"];
-
-        // If the connection has never been activated succesfully there is a
-        // high chance that it has no stored secrects.
-        if (timestamp != 0) {
-
-            QString secretsType;
-            if (keymgmt == "wpa-psk" && authalg == "open") {
-                secretsType = "802-11-wireless-security";
-            } else if (keymgmt == "wpa-eap" || keymgmt == "ieee8021x") {
-                secretsType = "802-1x";
-            }
+    auto settings = reply.value();
+    auto security = settings["802-11-wireless-security"];
+    auto keymgmt = security["key-mgmt"].toString();
+    auto authalg = security["auth-alg"].toString();
 
-            auto reply = m_iface.GetSecrets( secretsType );
-            reply.waitForFinished();
-            if(!reply.isValid()) {
-                qWarning() << "Error querying secrects: " << reply.error().message() << "\n";
-                return;
-            }
-            auto secrects = reply.value();
-            auto match = secrects.find( secretsType );
-            if (match != secrects.end()) {
-                auto secrects_security = *match;
-
-                if (keymgmt == "none") {
-                    password = secrects_security["wep-key0"].toString();
-                } else if (keymgmt == "wpa-psk" && authalg == "open") {
-                    password = secrects_security["psk"].toString();
-                } else if (keymgmt == "wpa-eap" || keymgmt == "ieee8021x") {
-                    password = secrects_security["password"].toString();
-                } else {
-                }
-            }
-        }
+    QString secretsType;
+    if (keymgmt == "wpa-psk" && authalg == "open") {
+        secretsType = "802-11-wireless-security";
+    } else if (keymgmt == "wpa-eap" || keymgmt == "ieee8021x") {
+        secretsType = "802-1x";
     }
 
-    Network() = delete;
-    explicit Network(QString path)
-        : path{path},
-          m_iface("org.freedesktop.NetworkManager",
-                  path,
-                  QDBusConnection::systemBus())
-    {
-        auto reply = m_iface.GetSettings();
-        reply.waitForFinished();
-        if(!reply.isValid()) {
-            qWarning() << "Error getting network info: " << reply.error().message() << "\n";
-            throw DontCare();
-        }
-        settings = reply.value();
-
-        try {
-            parseConnection();
-        } catch (const DontCare &) {
-            qDebug() << "Ignoring a network based on connection block.\n";
-            throw;
-        }
-
-        if (type == Type::wireless) {
-            try {
-                parseWireless();
-            } catch (const DontCare &) {
-                qDebug() << "Ignoring a network based on wireless block. " << qPrintable(m_iface.path()) << "\n";
-                throw;
-            }
-        }
+    // If the connection has never been activated succesfully there is a
+    // high chance that it has no stored secrects.
+    if (settings["connection"]["timestamp"].toULongLong() == 0
+            || secretsType.isEmpty()) {
+        Q_EMIT passwordFetched(path, QString());
+        return;
     }
 
-    OrgFreedesktopNetworkManagerSettingsConnectionInterface m_iface;
-    QMap<QString, QVariantMap> settings;
-};
-
-QList<QStringList> WifiDbusHelper::getPreviouslyConnectedWifiNetworks() {
-    QList<QStringList> networks;
-
-    OrgFreedesktopNetworkManagerSettingsInterface foo
+    OrgFreedesktopNetworkManagerSettingsConnectionInterface conn
             (NM_SERVICE,
-             "/org/freedesktop/NetworkManager/Settings",
+             path,
              m_systemBusConnection);
-    auto reply = foo.ListConnections();
-    reply.waitForFinished();
-    if (reply.isValid()) {
-        for(const auto &c: reply.value()) {
-            try {
-                Network network(c.path());
-                QStringList tmp;
-                tmp.push_back(network.id);
-                tmp.push_back(network.path);
-                tmp.push_back(network.password);
-                QString lastConnected = "";
-                QLocale locale;
-                if (network.timestamp != 0) {
-                    lastConnected = locale.toString(QDateTime::fromMSecsSinceEpoch(network.timestamp*1000), locale.dateFormat());
-                }
-                tmp.push_back(lastConnected);
-                networks.push_back(tmp);
-            } catch (const Network::DontCare &) {
-                continue;
-            }
-        }
+    auto watcher = new QDBusPendingCallWatcher(conn.GetSecrets(secretsType), this);
+    watcher->setProperty("path", path);
+    watcher->setProperty("secretsType", secretsType);
+    watcher->setProperty("keymgmt", keymgmt);
+    QObject::connect(watcher, SIGNAL(finished(QDBusPendingCallWatcher*)),
+                     this, SLOT(passwordSecretsFetched(QDBusPendingCallWatcher*)));
+}
+
+void WifiDbusHelper::passwordSecretsFetched(QDBusPendingCallWatcher *call)
+{
+    QDBusPendingReply<ConfigurationData> reply = *call;
+    QString path = call->property("path").toString();
+    QString secretsType = call->property("secretsType").toString();
+    QString keymgmt = call->property("keymgmt").toString();
+    call->deleteLater();
+
+    QString password;
+    if (reply.isError()) {
+        qWarning() << "Error querying secrects: " << reply.error().message() << "\n";
     } else {
-        qWarning() << "ERROR " << reply.error().message() << "\n";
+        auto secrets = reply.value().value(secretsType);
+        if (keymgmt == "wpa-psk") {
+            password = secrets["psk"].toString();
+        } else {
+            password = secrets["password"].toString();
+        }
     }
 
-    std::sort(networks.begin(), networks.end(), [](const QStringList &a, const QStringList &b){
-        return a[0].toLower() < b[0].toLower();
-    });
-    return networks;
+    Q_EMIT passwordFetched(path, password);
 }
 
 void WifiDbusHelper::forgetConnection(const QString dbus_path) {
@@ -535,47 +421,96 @@ void WifiDbusHelper::forgetConnection(const QString dbus_path) {
 }
 
 bool WifiDbusHelper::forgetActiveDevice() {
-    OrgFreedesktopNetworkManagerInterface mgr(NM_SERVICE,
-                                              NM_PATH,
-                                              m_systemBusConnection);
-    // find the first wlan adapter for now
-    auto reply1 = mgr.GetDevices();
-    reply1.waitForFinished();
-    if(!reply1.isValid()) {
-        qWarning() << __PRETTY_FUNCTION__ << ": Could not get network device: " << reply1.error().message() << "\n";
+    // A connect that was not sent yet is simply dropped; the device is
+    // still on whatever network it was before, which must be kept.
+    if (!m_pendingConnects.isEmpty()) {
+        failPendingConnects("Connection cancelled.");
+        return true;
+    }
+
+    // Otherwise the connection last made here is the one to forget,
+    // even if the device has not switched to it yet.
+    if (m_activationsInFlight > 0) {
+        m_forgetActivations = true;
+        return true;
+    }
+    if (!m_activatedConnection.isEmpty()) {
+        forgetConnection(m_activatedConnection);
+        m_activatedConnection.clear();
+        return true;
+    }
+
+    if (!m_mirror->isReady()) {
+        m_forgetWhenReady = true;
+        return true;
+    }
+
+    QString wifiDevice = m_mirror->wifiDevice();
+    if (wifiDevice.isEmpty()) {
+        qWarning() << __PRETTY_FUNCTION__ << ": Could not find wifi device\n";
         return false;
     }
-    auto devices = reply1.value();
-
-    QDBusObjectPath dev;
-    for (const auto &d : devices) {
-        QDBusInterface iface(NM_SERVICE, d.path(), NM_DEVICE_IFACE, m_systemBusConnection);
-
-        auto type_v = iface.property("DeviceType");
-        if (type_v.toUInt() == 2 /* NM_DEVICE_TYPE_WIFI */) {
-            if (d.path().isEmpty()) {
-                // didn't find a wifi device
-                qWarning() << __PRETTY_FUNCTION__ << ": Could not find wifi device\n";
-                return false;
-            } else {
-                auto ac_path_var = iface.property("ActiveConnection");
-                if(!ac_path_var.isValid()) {
-                    qWarning() << __PRETTY_FUNCTION__ << ": Could not get active connection property from "
-                               << d.path() << ".\n";
-                    return true;
-                }
-                QString ac_path = ac_path_var.value<QDBusObjectPath>().path();
-                QDBusInterface ac_iface(NM_SERVICE, ac_path, NM_ACTIVE_CONNECTION_IFACE, m_systemBusConnection);
-                auto conn_path_var = ac_iface.property("Connection");
-                if(!conn_path_var.isValid()) {
-                    qWarning() << __PRETTY_FUNCTION__ << ": Could not get connection path property from "
-                               << ac_path << ".\n";
-                    return false;
-                }
-                forgetConnection(conn_path_var.value<QDBusObjectPath>().path());
-            }
-            break;
-        }
+
+    // Asked afresh rather than taken from the mirror, which may still
+    // hold the previous network's active connection.
+    fetchObjectPath(wifiDevice, NM_DEVICE_IFACE, "ActiveConnection",
+                    SLOT(activeConnectionFetched(QDBusPendingCallWatcher*)));
+    return true;
+}
+
+void WifiDbusHelper::processPendingForget()
+{
+    if (m_forgetWhenReady) {
+        m_forgetWhenReady = false;
+        forgetActiveDevice();
+    }
+}
+
+void WifiDbusHelper::fetchObjectPath(const QString &path,
+                                     const QString &interface,
+                                     const QString &property,
+                                     const char *slot)
+{
+    QDBusMessage msg = QDBusMessage::createMethodCall(NM_SERVICE, path,
+                                                      DBUS_PROPERTIES_IFACE,
+                                                      "Get");
+    msg << interface << property;
+    auto watcher = new QDBusPendingCallWatcher(m_systemBusConnection.asyncCall(msg), this);
+    watcher->setProperty("path", path);
+    QObject::connect(watcher, SIGNAL(finished(QDBusPendingCallWatcher*)),
+                     this, slot);
+}
+
+static QString fetchedObjectPath(QDBusPendingCallWatcher *call, const char *property)
+{
+    QDBusPendingReply<QDBusVariant> reply = *call;
+    if (reply.isError()) {
+        qWarning() << "Could not get" << property << "property from"
+                   << call->property("path").toString() << ":"
+                   << reply.error().message();
+        return QString();
     }
-    return false;
+
+    QString path = qvariant_cast<QDBusObjectPath>(reply.value().variant()).path();
+    return path == "/" ? QString() : path;
+}
+
+void WifiDbusHelper::activeConnectionFetched(QDBusPendingCallWatcher *call)
+{
+    QString activeConnection = fetchedObjectPath(call, "ActiveConnection");
+    call->deleteLater();
+
+    if (!activeConnection.isEmpty()) {
+        fetchObjectPath(activeConnection, NM_ACTIVE_CONNECTION_IFACE, "Connection",
+                        SLOT(connectionFetched(QDBusPendingCallWatcher*)));
+    }
+}
+
+void WifiDbusHelper::connectionFetched(QDBusPendingCallWatcher *call)
+{
+    QString connection = fetchedObjectPath(call, "Connection");
+    call->deleteLater();
+
+    if (!connection.isEmpty())
+        forgetConnection(connection);
 }
@@ -21,8 +21,12 @@
 #define WIFI_DBUS_HELPER
 
 #include <QObject>
+#include <QSharedPointer>
 #include <QtDBus>
 
+class AccessPointIndex;
+class NetworkManagerMirror;
+
 /**
  * For sending specific dbus messages from QML.
  */
@@ -38,9 +42,15 @@ public:
     explicit WifiDbusHelper(const QDBusConnection &dbus, QObject *parent = nullptr);
     ~WifiDbusHelper() {};
 
+    // Asynchronous, the outcome is reported through connectFinished().
     Q_INVOKABLE void connect(QString ssid, int security, int auth, QStringList usernames, QStringList password, QStringList certs, int p2auth);
-    Q_INVOKABLE QList<QStringList> getPreviouslyConnectedWifiNetworks();
+    // Asynchronous, the result is reported through passwordFetched().
+    Q_INVOKABLE void fetchPassword(const QString dbus_path);
     Q_INVOKABLE void forgetConnection(const QString dbus_path);
+    // Forgets the connection this helper last made, or else the wifi
+    // device's active one; a connect not sent yet is dropped instead.
+    // True if that is done, or will be once NetworkManager answers;
+    // false if there is no wifi device.
     Q_INVOKABLE bool forgetActiveDevice();
 
 public Q_SLOTS:
@@ -49,9 +59,39 @@ public Q_SLOTS:
 Q_SIGNALS:
     void wifiIp4AddressChanged(QString wifiIp4Address);
     void deviceStateChanged(uint newState, uint reason);
+    void connectFinished(bool success, const QString &error);
+    void passwordFetched(const QString &dbusPath, const QString &password);
+
+private Q_SLOTS:
+    void processPendingConnects();
+    void mirrorChanged();
+    void passwordSettingsFetched(QDBusPendingCallWatcher *call);
+    void passwordSecretsFetched(QDBusPendingCallWatcher *call);
+    void connectionActivated(QDBusPendingCallWatcher *call);
+    void processPendingForget();
+    void activeConnectionFetched(QDBusPendingCallWatcher *call);
+    void connectionFetched(QDBusPendingCallWatcher *call);
 
 private:
+    struct ConnectRequest {
+        QByteArray ssid;
+        QMap<QString, QVariantMap> configuration;
+    };
+
+    void failPendingConnects(const QString &error);
+    void fetchObjectPath(const QString &path, const QString &interface,
+                         const QString &property, const char *slot);
+
     QDBusConnection m_systemBusConnection;
+    QSharedPointer<NetworkManagerMirror> m_mirror;
+    QSharedPointer<AccessPointIndex> m_apIndex;
+    QString m_wifiIp4Address;
+    QList<ConnectRequest> m_pendingConnects;
+    // The settings connection of the last AddAndActivateConnection.
+    QString m_activatedConnection;
+    int m_activationsInFlight;
+    bool m_forgetActivations;
+    bool m_forgetWhenReady;
     QString getWifiIpAddress();
 };
 
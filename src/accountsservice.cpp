@@ -20,6 +20,7 @@
 
 #include "accountsservice.h"
 
+#include <QDBusPendingCallWatcher>
 #include <QDBusReply>
 #include <QDebug>
 
@@ -157,3 +158,37 @@ bool AccountsService::customSetUserProperty(const QString &method,
     }
     return msg.type() == QDBusMessage::ReplyMessage;
 }
+
+QDBusPendingCall AccountsService::getUserPropertyAsync(const QString &interface,
+                                                       const QString &property)
+{
+    QDBusMessage msg = QDBusMessage::createMethodCall(
+                "org.freedesktop.Accounts",
+                m_objectPath,
+                "org.freedesktop.DBus.Properties",
+                "Get");
+    msg << interface << property;
+    return m_systemBusConnection.asyncCall(msg);
+}
+
+void AccountsService::customSetUserPropertyAsync(const QString &method,
+                                                 const QVariant &value)
+{
+    QDBusMessage msg = QDBusMessage::createMethodCall(
+                "org.freedesktop.Accounts",
+                m_objectPath,
+                "org.freedesktop.Accounts.User",
+                method);
+    msg << value;
+
+    QDBusPendingCallWatcher *watcher = new QDBusPendingCallWatcher(
+                m_systemBusConnection.asyncCall(msg), this);
+    const QString objectPath(m_objectPath);
+    connect(watcher, &QDBusPendingCallWatcher::finished,
+            [method, objectPath, value](QDBusPendingCallWatcher *call) {
+        if (call->isError()) {
+            qWarning() << "Could not call AccountsService method" << method << "for object" << objectPath << "with argument" << value << ":" << call->error().message();
+        }
+        call->deleteLater();
+    });
+}
@@ -21,6 +21,7 @@
 #ifndef ACCOUNTSSERVICE_H
 #define ACCOUNTSSERVICE_H
 
+#include <QDBusPendingCall>
 #include <QDBusServiceWatcher>
 #include <QStringList>
 #include <QtDBus/QDBusInterface>
@@ -40,6 +41,11 @@ public:
                          const QVariant &value);
     bool customSetUserProperty(const QString &method,
                                const QVariant &value);
+    // Non-blocking variants; the reply to a Get carries a QDBusVariant.
+    QDBusPendingCall getUserPropertyAsync(const QString &interface,
+                                          const QString &property);
+    void customSetUserPropertyAsync(const QString &method,
+                                    const QVariant &value);
 
 
 public Q_SLOTS:
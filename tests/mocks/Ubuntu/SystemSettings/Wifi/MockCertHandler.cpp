@@ -101,3 +101,15 @@ bool MockFileHandler::removeFile(QString filename)
 {
     return false;
 }
+
+bool MockFileHandler::importFile(QString filename, int type)
+{
+    Q_UNUSED(type);
+    Q_EMIT importFinished(true, QStringList(filename), 0);
+    return true;
+}
+
+bool MockFileHandler::importing() const
+{
+    return false;
+}
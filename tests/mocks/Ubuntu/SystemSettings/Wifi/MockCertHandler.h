@@ -22,6 +22,7 @@
 #include <QAbstractListModel>
 #include <QObject>
 #include <QList>
+#include <QStringList>
 
 struct MockFile {
     QString fileName;
@@ -66,12 +67,27 @@ public:
 class MockFileHandler : public QObject
 {
     Q_OBJECT
+    Q_PROPERTY(bool importing READ importing NOTIFY importingChanged)
 public:
+    enum FileType {
+        Certificate = 0,
+        PrivateKey,
+        PacFile,
+    };
+    Q_ENUMS(FileType)
+
     Q_INVOKABLE QByteArray getCertContent(QString filename);
     Q_INVOKABLE QString moveCertFile(QString filename);
     Q_INVOKABLE QString moveKeyFile(QString filename);
     Q_INVOKABLE QString movePacFile(QString filename);
     Q_INVOKABLE bool removeFile(QString filename);
+    Q_INVOKABLE bool importFile(QString filename, int type);
+    bool importing() const;
+
+Q_SIGNALS:
+    void importingChanged();
+    void importProgress(int done, int total);
+    void importFinished(bool success, const QStringList &files, int duplicates);
 };
 
 class MockCertificateListModel : public MockAbstractListModel
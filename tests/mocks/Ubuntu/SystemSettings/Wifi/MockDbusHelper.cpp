@@ -34,9 +34,9 @@ void MockDbusHelper::connect(QString ssid, int security, int auth, QStringList u
     m_connect["p2auth"] = p2auth;
 }
 
-QList<QStringList> MockDbusHelper::getPreviouslyConnectedWifiNetworks()
+void MockDbusHelper::fetchPassword(const QString dbus_path)
 {
-    return QList<QStringList>();
+    Q_EMIT passwordFetched(dbus_path, QString());
 }
 
 void MockDbusHelper::forgetConnection(const QString dbus_path)
@@ -64,6 +64,11 @@ void MockDbusHelper::mockDeviceStateChanged(uint newState, uint reason)
     Q_EMIT deviceStateChanged(newState, reason);
 }
 
+void MockDbusHelper::mockConnectFinished(bool success, const QString &error)
+{
+    Q_EMIT connectFinished(success, error);
+}
+
 QVariantMap MockDbusHelper::getConnectArguments()
 {
     return m_connect;
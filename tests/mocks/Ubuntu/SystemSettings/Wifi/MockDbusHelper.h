@@ -33,12 +33,13 @@ public:
     ~MockDbusHelper() {};
 
     Q_INVOKABLE void connect(QString ssid, int security, int auth, QStringList usernames, QStringList password, QStringList certs, int p2auth);
-    Q_INVOKABLE QList<QStringList> getPreviouslyConnectedWifiNetworks();
+    Q_INVOKABLE void fetchPassword(const QString dbus_path);
     Q_INVOKABLE void forgetConnection(const QString dbus_path);
     Q_INVOKABLE bool forgetActiveDevice();
     QString getWifiIpAddress();
 
     Q_INVOKABLE void mockDeviceStateChanged(uint newState, uint reason);
+    Q_INVOKABLE void mockConnectFinished(bool success, const QString &error);
     Q_INVOKABLE QVariantMap getConnectArguments(); // mock only
     Q_INVOKABLE bool getForgetActiveDeviceCalled(); // mock only
 
@@ -48,6 +49,8 @@ public Q_SLOTS:
 Q_SIGNALS:
     void wifiIp4AddressChanged(QString wifiIp4Address);
     void deviceStateChanged(uint newState, uint reason);
+    void connectFinished(bool success, const QString &error);
+    void passwordFetched(const QString &dbusPath, const QString &password);
 private:
     // This stores params passed to connect().
     bool forgetActiveDeviceCalled = false;
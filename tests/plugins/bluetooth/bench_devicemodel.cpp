@@ -0,0 +1,386 @@
+/*
+ * Copyright 2016 Canonical Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of version 3 of the GNU Lesser General Public
+ * License as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/*
+ * Scale benchmark for DeviceModel and DeviceFilter.
+ *
+ * Devices are added to a FakeBluez adapter until the requested population
+ * is reached, then devices disappear, appear and change RSSI at the
+ * requested rates for the requested time. The result is printed as JSON:
+ * model and filter latencies from the fake's change to the model signal,
+ * D-Bus calls the model made per device (counted with dbus-monitor),
+ * peak RSS and main thread CPU time per second of churn.
+ */
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QHash>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QProcess>
+#include <QTimer>
+
+#include <algorithm>
+#include <functional>
+#include <random>
+#include <sys/resource.h>
+#include <time.h>
+
+#include "devicemodel.h"
+#include "fakebluez.h"
+
+using namespace Bluez;
+
+namespace {
+
+qint64 threadCpuNsecs()
+{
+    timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return qint64(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
+
+long peakRssKb()
+{
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+}
+
+QString addressOf(int n)
+{
+    return QString("00:42:%1:%2:%3:%4")
+        .arg((n >> 24) & 0xff, 2, 16, QChar('0'))
+        .arg((n >> 16) & 0xff, 2, 16, QChar('0'))
+        .arg((n >> 8) & 0xff, 2, 16, QChar('0'))
+        .arg(n & 0xff, 2, 16, QChar('0')).toUpper();
+}
+
+/* Time from a change made on the fake to the matching model signal. */
+class Latencies
+{
+public:
+    void start(const QString &key, qint64 now)
+    {
+        // Keep the oldest: that is the one the user waited for.
+        if (!m_started.contains(key))
+            m_started.insert(key, now);
+    }
+
+    void finish(const QString &key, qint64 now)
+    {
+        auto it = m_started.find(key);
+        if (it == m_started.end())
+            return;
+        m_samples.append(now - it.value());
+        m_started.erase(it);
+    }
+
+    QJsonObject summary() const
+    {
+        QVector<qint64> sorted = m_samples;
+        std::sort(sorted.begin(), sorted.end());
+
+        auto percentile = [&](int p) {
+            if (sorted.isEmpty())
+                return 0.0;
+            int i = qMin(sorted.size() - 1, sorted.size() * p / 100);
+            return sorted[i] / 1e6;
+        };
+
+        QJsonObject json;
+        json["count"] = sorted.size();
+        json["lost"] = m_started.size();
+        json["p50_ms"] = percentile(50);
+        json["p95_ms"] = percentile(95);
+        json["max_ms"] = sorted.isEmpty() ? 0.0 : sorted.last() / 1e6;
+        return json;
+    }
+
+private:
+    QHash<QString, qint64> m_started;
+    QVector<qint64> m_samples;
+};
+
+struct Measurements
+{
+    Latencies add;
+    Latencies remove;
+    Latencies rssi;
+
+    QJsonObject summary() const
+    {
+        QJsonObject json;
+        json["add"] = add.summary();
+        json["remove"] = remove.summary();
+        json["rssi"] = rssi.summary();
+        return json;
+    }
+};
+
+void watchModel(QAbstractItemModel *model, Measurements *m, QElapsedTimer *clock)
+{
+    auto addressAt = [=](int row) {
+        return model->data(model->index(row, 0), DeviceModel::AddressRole).toString();
+    };
+
+    QObject::connect(model, &QAbstractItemModel::rowsInserted,
+                     [=](const QModelIndex &, int first, int last) {
+        for (int row = first; row <= last; row++)
+            m->add.finish(addressAt(row), clock->nsecsElapsed());
+    });
+    QObject::connect(model, &QAbstractItemModel::rowsAboutToBeRemoved,
+                     [=](const QModelIndex &, int first, int last) {
+        for (int row = first; row <= last; row++)
+            m->remove.finish(addressAt(row), clock->nsecsElapsed());
+    });
+    QObject::connect(model, &QAbstractItemModel::dataChanged,
+                     [=](const QModelIndex &topLeft, const QModelIndex &bottomRight,
+                         const QVector<int> &roles) {
+        if (!roles.isEmpty() && !roles.contains(DeviceModel::StrengthRole))
+            return;
+        for (int row = topLeft.row(); row <= bottomRight.row(); row++)
+            m->rssi.finish(addressAt(row), clock->nsecsElapsed());
+    });
+}
+
+void spin(int msecs)
+{
+    QTimer::singleShot(msecs, QCoreApplication::instance(), SLOT(quit()));
+    QCoreApplication::exec();
+}
+
+/* Method calls from sender, by member, from dbus-monitor --profile output */
+QJsonObject countCalls(const QByteArray &profile, const QString &sender, int *total)
+{
+    QJsonObject byMember;
+    *total = 0;
+
+    Q_FOREACH(const QByteArray &line, profile.split('\n')) {
+        QList<QByteArray> fields = line.split('\t');
+        // mc  time  serial  sender  destination  path  interface  member
+        if (fields.size() < 8 || fields[0] != "mc" || fields[3] != sender.toUtf8())
+            continue;
+        const QString member = QString::fromUtf8(fields[6] + "." + fields[7]);
+        byMember[member] = byMember.value(member).toInt() + 1;
+        (*total)++;
+    }
+
+    return byMember;
+}
+
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("DeviceModel scale benchmark on FakeBluez");
+    parser.addHelpOption();
+    QCommandLineOption devicesOption("devices", "Device population.", "n", "500");
+    QCommandLineOption appearOption("appear-rate", "Devices added per second while filling.", "n", "200");
+    QCommandLineOption churnOption("churn-rate", "Devices replaced per second afterwards.", "n", "10");
+    QCommandLineOption rssiOption("rssi-rate", "RSSI changes per second afterwards.", "n", "200");
+    QCommandLineOption durationOption("duration", "Seconds of churn.", "s", "10");
+    QCommandLineOption seedOption("seed", "Random seed.", "n", "1");
+    QCommandLineOption outputOption("output", "Write the JSON here instead of stdout.", "file");
+    parser.addOptions({devicesOption, appearOption, churnOption, rssiOption,
+                       durationOption, seedOption, outputOption});
+    parser.process(app);
+
+    const int population = parser.value(devicesOption).toInt();
+    const double appearRate = parser.value(appearOption).toDouble();
+    const double churnRate = parser.value(churnOption).toDouble();
+    const double rssiRate = parser.value(rssiOption).toDouble();
+    const int duration = parser.value(durationOption).toInt();
+    std::mt19937 rng(parser.value(seedOption).toUInt());
+
+    qDBusRegisterMetaType<InterfaceList>();
+    qDBusRegisterMetaType<ManagedObjectList>();
+
+    FakeBluez bluez;
+    bluez.addAdapter("new0", "bluetoothBench");
+
+    // The model gets a connection of its own so its calls can be told
+    // apart from those driving the fake.
+    QDBusConnection modelBus = QDBusConnection::connectToBus(bluez.dbusAddress(), "bench-model");
+
+    QProcess monitor;
+    monitor.start("dbus-monitor", QStringList()
+                  << "--address" << bluez.dbusAddress() << "--profile"
+                  << "type='method_call',destination='org.bluez'"
+                  << "type='method_call',interface='org.freedesktop.DBus',member='AddMatch'");
+    const bool monitoring = monitor.waitForStarted();
+    if (!monitoring)
+        qWarning() << "dbus-monitor not available, D-Bus calls will not be counted";
+
+    QElapsedTimer clock;
+    clock.start();
+
+    DeviceModel model(modelBus);
+    DeviceFilter filter;
+    filter.filterOnConnections(Device::Connection::Disconnected);
+    filter.setSourceModel(&model);
+
+    Measurements modelTimes;
+    Measurements filterTimes;
+    watchModel(&model, &modelTimes, &clock);
+    watchModel(&filter, &filterTimes, &clock);
+
+    spin(500);
+
+    QStringList alive;
+    QHash<QString, qint16> rssis;
+    int created = 0;
+    qint64 driverNsecs = 0;
+
+    auto addOne = [&]() {
+        const QString address = addressOf(created);
+        const qint64 cpu = threadCpuNsecs();
+        modelTimes.add.start(address, clock.nsecsElapsed());
+        filterTimes.add.start(address, clock.nsecsElapsed());
+        bluez.addDevice(QString("Device %1").arg(created), address);
+        driverNsecs += threadCpuNsecs() - cpu;
+        alive.append(address);
+        created++;
+    };
+
+    auto removeOne = [&]() {
+        if (alive.isEmpty())
+            return;
+        const QString address = alive.takeAt(rng() % alive.size());
+        rssis.remove(address);
+        const qint64 cpu = threadCpuNsecs();
+        modelTimes.remove.start(address, clock.nsecsElapsed());
+        filterTimes.remove.start(address, clock.nsecsElapsed());
+        bluez.removeDevice(address);
+        driverNsecs += threadCpuNsecs() - cpu;
+    };
+
+    auto changeOne = [&]() {
+        if (alive.isEmpty())
+            return;
+        const QString address = alive.at(rng() % alive.size());
+        // Alternates between values far enough apart to cross a Strength
+        // bucket, so that every change is one the model has to report.
+        const qint16 rssi = rssis.value(address) == -50 ? -90 : -50;
+        rssis.insert(address, rssi);
+        const qint64 cpu = threadCpuNsecs();
+        modelTimes.rssi.start(address, clock.nsecsElapsed());
+        filterTimes.rssi.start(address, clock.nsecsElapsed());
+        bluez.setDeviceRssi(address, rssi);
+        driverNsecs += threadCpuNsecs() - cpu;
+    };
+
+    // Operations are spread over 10 ms ticks at the requested rates.
+    const int TICK_MSEC = 10;
+    auto runAt = [&](double rate, double &credit, std::function<void()> op) {
+        credit += rate * TICK_MSEC / 1000.0;
+        while (credit >= 1.0) {
+            op();
+            credit -= 1.0;
+        }
+    };
+
+    QTimer ticker;
+    ticker.setInterval(TICK_MSEC);
+
+    // Fill
+    double appearCredit = 0;
+    QObject::connect(&ticker, &QTimer::timeout, [&]() {
+        runAt(appearRate, appearCredit, [&]() {
+            if (created < population)
+                addOne();
+        });
+        if (created >= population)
+            app.quit();
+    });
+    const qint64 fillStart = clock.elapsed();
+    ticker.start();
+    app.exec();
+    ticker.stop();
+    ticker.disconnect();
+    const qint64 fillMsecs = clock.elapsed() - fillStart;
+    spin(500);
+    const int modelRowsAfterFill = model.rowCount();
+
+    // Churn
+    double churnCredit = 0;
+    double rssiCredit = 0;
+    QObject::connect(&ticker, &QTimer::timeout, [&]() {
+        runAt(churnRate, churnCredit, [&]() { removeOne(); addOne(); });
+        runAt(rssiRate, rssiCredit, changeOne);
+    });
+    driverNsecs = 0;
+    const qint64 churnCpuStart = threadCpuNsecs();
+    const qint64 churnStart = clock.elapsed();
+    QTimer::singleShot(duration * 1000, &app, SLOT(quit()));
+    ticker.start();
+    app.exec();
+    ticker.stop();
+    const double churnSeconds = (clock.elapsed() - churnStart) / 1000.0;
+    const qint64 modelCpu = threadCpuNsecs() - churnCpuStart - driverNsecs;
+    spin(500);
+
+    QJsonObject calls;
+    if (monitoring) {
+        monitor.terminate();
+        monitor.waitForFinished();
+        int total = 0;
+        QJsonObject byMember = countCalls(monitor.readAllStandardOutput(),
+                                          modelBus.baseService(), &total);
+        calls["total"] = total;
+        calls["per_device"] = created > 0 ? double(total) / created : 0.0;
+        calls["by_member"] = byMember;
+    }
+
+    QJsonObject parameters;
+    parameters["devices"] = population;
+    parameters["appear_rate"] = appearRate;
+    parameters["churn_rate"] = churnRate;
+    parameters["rssi_rate"] = rssiRate;
+    parameters["duration_s"] = duration;
+
+    QJsonObject result;
+    result["parameters"] = parameters;
+    result["fill_ms"] = fillMsecs;
+    result["rows_after_fill"] = modelRowsAfterFill;
+    result["devices_created"] = created;
+    result["model"] = modelTimes.summary();
+    result["filter"] = filterTimes.summary();
+    result["dbus_calls"] = calls;
+    result["peak_rss_kb"] = qint64(peakRssKb());
+    result["main_thread_ms_per_s"] = churnSeconds > 0 ? modelCpu / 1e6 / churnSeconds : 0.0;
+
+    const QByteArray json = QJsonDocument(result).toJson();
+    if (parser.isSet(outputOption)) {
+        QFile file(parser.value(outputOption));
+        if (!file.open(QIODevice::WriteOnly)) {
+            qCritical() << "Cannot write" << file.fileName();
+            return 1;
+        }
+        file.write(json);
+    } else {
+        fputs(json.constData(), stdout);
+    }
+
+    return 0;
+}
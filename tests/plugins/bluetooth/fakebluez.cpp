@@ -111,6 +111,80 @@ FakeBluez::disconnectDevice(const QString &address)
     }
 }
 
+const QString
+FakeBluez::devicePath(const QString &address)
+{
+    return QString("%1/dev_%2").arg(currentAdapterPath())
+                               .arg(address.toUpper().replace(':', '_'));
+}
+
+void
+FakeBluez::removeDevice(const QString &address)
+{
+    QDBusInterface adapter(BLUEZ_SERVICE, currentAdapterPath(),
+                           BLUEZ_ADAPTER_IFACE,
+                           m_dbusTestRunner.systemConnection());
+
+    const QString path = devicePath(address);
+    QDBusReply<void> reply = adapter.call("RemoveDevice",
+                                          QVariant::fromValue(QDBusObjectPath(path)));
+
+    if (reply.isValid()) {
+        m_devices.removeAll(path);
+    } else {
+        qWarning() << "Failed to remove mock device:" << reply.error().message();
+    }
+}
+
+void
+FakeBluez::setDeviceRssi(const QString &address, qint16 rssi)
+{
+    setProperty(devicePath(address), BLUEZ_DEVICE_IFACE, "RSSI",
+                QVariant::fromValue(QDBusVariant(QVariant::fromValue(rssi))));
+}
+
+QList<MethodCall>
+FakeBluez::adapterMethodCalls(const QString &method)
+{
+    QDBusInterface mock(BLUEZ_SERVICE, currentAdapterPath(), DBUSMOCK_IFACE,
+                        m_dbusTestRunner.systemConnection());
+
+    QDBusReply<QList<MethodCall>> reply = mock.call("GetMethodCalls", method);
+
+    if (!reply.isValid()) {
+        qWarning() << "Failed to get mock adapter calls:" << reply.error().message();
+    }
+
+    return reply.isValid() ? reply.value() : QList<MethodCall>();
+}
+
+void
+FakeBluez::clearAdapterMethodCalls()
+{
+    QDBusInterface mock(BLUEZ_SERVICE, currentAdapterPath(), DBUSMOCK_IFACE,
+                        m_dbusTestRunner.systemConnection());
+
+    QDBusReply<void> reply = mock.call("ClearCalls");
+
+    if (!reply.isValid()) {
+        qWarning() << "Failed to clear mock adapter calls:" << reply.error().message();
+    }
+}
+
+void
+FakeBluez::addAdapterMethod(const QString &method, const QString &inSignature)
+{
+    QDBusInterface mock(BLUEZ_SERVICE, currentAdapterPath(), DBUSMOCK_IFACE,
+                        m_dbusTestRunner.systemConnection());
+
+    QDBusReply<void> reply = mock.call("AddMethod", BLUEZ_ADAPTER_IFACE, method,
+                                       inSignature, QString(), QString());
+
+    if (!reply.isValid()) {
+        qWarning() << "Failed to add mock adapter method:" << reply.error().message();
+    }
+}
+
 QVariant
 FakeBluez::getProperty(const QString &path,
                        const QString &interface,
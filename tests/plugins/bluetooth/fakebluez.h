@@ -26,6 +26,7 @@
 #include <QDBusInterface>
 
 #include <libqtdbusmock/DBusMock.h>
+#include <libqtdbusmock/MethodCall.h>
 #include <libqtdbustest/DBusTestRunner.h>
 
 #define BLUEZ_SERVICE "org.bluez"
@@ -36,6 +37,7 @@
 #define BLUEZ_DEVICE_IFACE "org.bluez.Device1"
 
 #define FREEDESKTOP_PROPERTIES_IFACE "org.freedesktop.DBus.Properties"
+#define DBUSMOCK_IFACE "org.freedesktop.DBus.Mock"
 
 using namespace QtDBusTest;
 using namespace QtDBusMock;
@@ -64,12 +66,22 @@ public:
     const QString currentAdapterPath() { return QString("/org/bluez/%1").arg(m_currentAdapter); }
     const QList<QString> devices() { return m_devices; }
     const QDBusConnection & dbus() { return m_dbusTestRunner.systemConnection(); }
+    const QString & dbusAddress() { return m_dbusTestRunner.systemBus(); }
+    const QString devicePath(const QString &address);
 
     QString addAdapter(const QString &name, const QString &system_name);
     QString addDevice(const QString &name, const QString &address);
     void pairDevice(const QString &address);
     void connectDevice(const QString &address);
     void disconnectDevice(const QString &address);
+    void removeDevice(const QString &address);
+    void setDeviceRssi(const QString &address, qint16 rssi);
+
+    // The calls the current adapter received, as recorded by dbusmock.
+    QList<MethodCall> adapterMethodCalls(const QString &method);
+    void clearAdapterMethodCalls();
+    // For adapter methods the bluez5 template does not provide.
+    void addAdapterMethod(const QString &method, const QString &inSignature);
 
     QVariant getProperty(const QString &path,
                          const QString &interface,
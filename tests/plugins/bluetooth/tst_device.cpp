@@ -52,6 +52,7 @@ private Q_SLOTS:
     void testMakeTrusted();
     void testConnect();
     void testDisconnect();
+    void testCompareNamelessByAddress();
 
     void cleanup();
 
@@ -196,5 +197,25 @@ void DeviceTest::testDisconnect()
     QCOMPARE(m_device->getConnection(), Device::Disconnected);
 }
 
+void DeviceTest::testCompareNamelessByAddress()
+{
+    QVariantMap nameless;
+    nameless.insert("address", "FF:00:00:00:00:01");
+    QVariantMap alpha;
+    alpha.insert("address", "00:00:00:00:00:02");
+    alpha.insert("name", "Alpha");
+    QVariantMap zed;
+    zed.insert("address", "00:00:00:00:00:03");
+    zed.insert("name", "Zed");
+
+    Device namelessDevice(nameless);
+    Device alphaDevice(alpha);
+    Device zedDevice(zed);
+
+    // Sorted by its address, not ahead of everything else.
+    QVERIFY(alphaDevice.compareName(namelessDevice) < 0);
+    QVERIFY(namelessDevice.compareName(zedDevice) < 0);
+}
+
 QTEST_MAIN(DeviceTest)
 #include "tst_device.moc"
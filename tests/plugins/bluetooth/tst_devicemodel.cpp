@@ -16,8 +16,10 @@
  * Boston, MA 02110-1301, USA.
  */
 
+#include <QFile>
 #include <QTest>
 #include <QSignalSpy>
+#include <QStandardPaths>
 #include <QThread>
 
 #include "bluetooth.h"
@@ -37,6 +39,7 @@ private:
 
 private:
     void processEvents(unsigned int msecs = 500);
+    void setDiscovering(bool value);
 
 private Q_SLOTS:
     void init();
@@ -44,6 +47,14 @@ private Q_SLOTS:
     void testDeviceFound();
     void testGetDeviceFromAddress();
     void testGetDeviceFromPath();
+    void testLookupsAgree();
+    void testChangeCarriesRoles();
+    void testCachedDevicesShownAtOnce();
+    void testCachedDevicesDroppedWithoutAdapter();
+    void testDeviceFromPathNotShownUntilValid();
+    void testDiscoveryStopsWhenPageHidden();
+    void testIdleGapDoublesUpToCap();
+    void testDiscoveryFilterOnBattery();
     void cleanup();
 
 };
@@ -54,8 +65,18 @@ void DeviceModelTest::processEvents(unsigned int msecs)
     QCoreApplication::instance()->exec();
 }
 
+/* The bluez5 template does not change Discovering on Start/StopDiscovery. */
+void DeviceModelTest::setDiscovering(bool value)
+{
+    m_bluezMock->setProperty(m_bluezMock->currentAdapterPath(),
+                             BLUEZ_ADAPTER_IFACE,
+                             "Discovering",
+                             QVariant(value));
+}
+
 void DeviceModelTest::init()
 {
+    QStandardPaths::setTestModeEnabled(true);
     qDBusRegisterMetaType<InterfaceList>();
     qDBusRegisterMetaType<ManagedObjectList>();
 
@@ -76,6 +97,10 @@ void DeviceModelTest::cleanup()
 {
     delete m_bluezMock;
     delete m_devicemodel;
+
+    // Each test starts without remembered devices.
+    QFile::remove(QStandardPaths::writableLocation(QStandardPaths::CacheLocation)
+                  + "/bluetooth-devices.ini");
 }
 
 void DeviceModelTest::testDeviceFoundOnStart()
@@ -112,5 +137,162 @@ void DeviceModelTest::testGetDeviceFromPath()
     QVERIFY(!device->getPath().isEmpty());
 }
 
+void DeviceModelTest::testLookupsAgree()
+{
+    QList<QString> devices = m_bluezMock->devices();
+
+    auto byPath = m_devicemodel->getDeviceFromPath(devices.at(0));
+    QVERIFY(byPath);
+
+    auto byAddress = m_devicemodel->getDeviceFromAddress(byPath->getAddress());
+    QCOMPARE(byAddress.data(), byPath.data());
+
+    QVERIFY(!m_devicemodel->getDeviceFromPath("/org/bluez/new0/dev_unknown"));
+    QVERIFY(!m_devicemodel->getDeviceFromAddress("00:00:00:00:00:00"));
+}
+
+void DeviceModelTest::testChangeCarriesRoles()
+{
+    qRegisterMetaType<QVector<int>>();
+    QSignalSpy spy(m_devicemodel, SIGNAL(dataChanged(QModelIndex, QModelIndex, QVector<int>)));
+
+    m_bluezMock->connectDevice("00:00:de:ad:be:ef");
+    processEvents();
+
+    bool connectionChanged = false;
+    for (const QList<QVariant> &args : spy) {
+        QVector<int> roles = args.at(2).value<QVector<int>>();
+        // Never a whole-row change
+        QVERIFY(!roles.isEmpty());
+        connectionChanged |= roles.contains(DeviceModel::ConnectionRole);
+    }
+    QVERIFY(connectionChanged);
+}
+
+void DeviceModelTest::testCachedDevicesShownAtOnce()
+{
+    // The paired device is remembered by the first model...
+    delete m_devicemodel;
+
+    // ...and shown by the next one before BlueZ answered.
+    m_devicemodel = new DeviceModel(*m_dbus);
+    QCOMPARE(m_devicemodel->rowCount(), 1);
+    QModelIndex row = m_devicemodel->index(0, 0);
+    QCOMPARE(m_devicemodel->data(row, DeviceModel::AddressRole).toString(),
+             QString("00:00:de:ad:be:ef"));
+    QVERIFY(m_devicemodel->data(row, DeviceModel::StaleRole).toBool());
+
+    processEvents();
+
+    QCOMPARE(m_devicemodel->rowCount(), 1);
+    row = m_devicemodel->index(0, 0);
+    QVERIFY(!m_devicemodel->data(row, DeviceModel::StaleRole).toBool());
+}
+
+void DeviceModelTest::testCachedDevicesDroppedWithoutAdapter()
+{
+    // The paired device is remembered...
+    delete m_devicemodel;
+
+    // ...but BlueZ comes back without any adapter to confirm it.
+    delete m_bluezMock;
+    m_bluezMock = new FakeBluez();
+    delete m_dbus;
+    m_dbus = new QDBusConnection(m_bluezMock->dbus());
+
+    m_devicemodel = new DeviceModel(*m_dbus);
+    QCOMPARE(m_devicemodel->rowCount(), 1);
+
+    processEvents();
+
+    QCOMPARE(m_devicemodel->rowCount(), 0);
+
+    // It is still remembered for when BlueZ can tell.
+    delete m_devicemodel;
+    m_devicemodel = new DeviceModel(*m_dbus);
+    QCOMPARE(m_devicemodel->rowCount(), 1);
+}
+
+void DeviceModelTest::testDeviceFromPathNotShownUntilValid()
+{
+    // As for an agent request about a device BlueZ cannot describe.
+    QDBusObjectPath path("/org/bluez/new0/dev_00_0B_AD_C0_FF_EE");
+    auto device = m_devicemodel->addDeviceFromPath(path);
+    QVERIFY(device);
+    QCOMPARE(m_devicemodel->rowCount(), 1);
+    QCOMPARE(m_devicemodel->getDeviceFromPath(path.path()).data(), device.data());
+
+    processEvents();
+
+    QVERIFY(device->hasFetchedProperties());
+    QCOMPARE(m_devicemodel->rowCount(), 1);
+    QVERIFY(!m_devicemodel->getDeviceFromPath(path.path()));
+}
+
+void DeviceModelTest::testDiscoveryStopsWhenPageHidden()
+{
+    setDiscovering(true);
+    processEvents();
+    QVERIFY(m_devicemodel->isDiscovering());
+
+    m_bluezMock->clearAdapterMethodCalls();
+    m_devicemodel->setPageVisible(false);
+    processEvents();
+
+    QCOMPARE(m_bluezMock->adapterMethodCalls("StopDiscovery").size(), 1);
+
+    // Nobody is looking, so no discovery is started again.
+    setDiscovering(false);
+    processEvents();
+    QVERIFY(!m_devicemodel->isDiscovering());
+
+    m_devicemodel->startDiscovery();
+    processEvents();
+
+    QVERIFY(m_bluezMock->adapterMethodCalls("StartDiscovery").isEmpty());
+}
+
+void DeviceModelTest::testIdleGapDoublesUpToCap()
+{
+    const int cap = 5 * 60 * 1000;
+
+    setDiscovering(true);
+    processEvents();
+
+    // Discovery windows that turn up nothing new.
+    int expected = m_devicemodel->discoveryIdleDuration();
+    while (expected < cap) {
+        QVERIFY(QMetaObject::invokeMethod(m_devicemodel, "slotDiscoveryTimeout"));
+        expected = qMin(expected * 2, cap);
+        QCOMPARE(m_devicemodel->discoveryIdleDuration(), expected);
+    }
+
+    QVERIFY(QMetaObject::invokeMethod(m_devicemodel, "slotDiscoveryTimeout"));
+    QCOMPARE(m_devicemodel->discoveryIdleDuration(), cap);
+}
+
+void DeviceModelTest::testDiscoveryFilterOnBattery()
+{
+    m_bluezMock->addAdapterMethod("SetDiscoveryFilter", "a{sv}");
+    setDiscovering(true);
+    processEvents();
+
+    m_bluezMock->clearAdapterMethodCalls();
+
+    QVariantMap changed;
+    changed.insert("OnBattery", true);
+    QVERIFY(QMetaObject::invokeMethod(m_devicemodel, "slotPowerSourceChanged",
+                                      Q_ARG(QString, "org.freedesktop.UPower"),
+                                      Q_ARG(QVariantMap, changed),
+                                      Q_ARG(QStringList, QStringList())));
+    processEvents();
+
+    QList<MethodCall> calls = m_bluezMock->adapterMethodCalls("SetDiscoveryFilter");
+    QCOMPARE(calls.size(), 1);
+    QVariantMap filter = qdbus_cast<QVariantMap>(calls.first().args().first());
+    QCOMPARE(filter.value("Transport").toString(), QString("auto"));
+    QVERIFY(filter.contains("RSSI"));
+}
+
 QTEST_MAIN(DeviceModelTest)
 #include "tst_devicemodel.moc"
@@ -0,0 +1,190 @@
+/*
+ * This file is part of system-settings
+ *
+ * Copyright (C) 2016 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3, as published
+ * by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranties of
+ * MERCHANTABILITY, SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "accesspointmodel.h"
+#include "fakenetworkmanager.h"
+
+#include <QTest>
+#include <QSignalSpy>
+
+class TstAccessPointModel: public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void init()
+    {
+        QVariantMap parameters;
+        m_nmMock = new FakeNetworkManager(parameters);
+        m_dbus = new QDBusConnection(m_nmMock->dbus());
+        m_mock = new QDBusInterface(NM_SERVICE,
+                                    NM_MAIN_OBJECT,
+                                    "org.freedesktop.DBus.Mock",
+                                    *m_dbus);
+
+        QDBusReply<QString> reply = m_mock->call("AddWiFiDevice", "0", "wlan0", 100);
+        QVERIFY2(reply.isValid(), "Failed to create device");
+        m_devPath = reply.value();
+
+        m_instance = new AccessPointModel(*m_dbus);
+    }
+    void cleanup()
+    {
+        delete m_instance;
+        delete m_mock;
+        delete m_dbus;
+        delete m_nmMock;
+    }
+    void testGroupsBySsid()
+    {
+        addAccessPoint("ap1", "home", "00:00:00:00:00:01", 40, 0x100);
+        addAccessPoint("ap2", "home", "00:00:00:00:00:02", 70, 0x100);
+        addAccessPoint("ap3", "cafe", "00:00:00:00:00:03", 50, 0);
+
+        QTRY_COMPARE(m_instance->rowCount(), 2);
+
+        // Strongest first.
+        QCOMPARE(data(0, AccessPointModel::SsidRole).toString(), QString("home"));
+        QCOMPARE(data(0, AccessPointModel::StrengthRole).toUInt(), (uint) 70);
+        QCOMPARE(data(0, AccessPointModel::SecuredRole).toBool(), true);
+        QCOMPARE(data(0, AccessPointModel::AccessPointPathRole).toString(),
+                 QString("/org/freedesktop/NetworkManager/AccessPoint/ap2"));
+        QCOMPARE(data(1, AccessPointModel::SsidRole).toString(), QString("cafe"));
+        QCOMPARE(data(1, AccessPointModel::SecuredRole).toBool(), false);
+    }
+    void testSortsByStrength()
+    {
+        for (int i = 0; i < 10; i++) {
+            addAccessPoint(QString("ap%1").arg(i), QString("net%1").arg(i),
+                           QString("00:00:00:00:00:%1").arg(i, 2, 10, QChar('0')),
+                           10 + i, 0);
+        }
+
+        QTRY_COMPARE(m_instance->rowCount(), 10);
+        for (int row = 0; row < 10; row++) {
+            QCOMPARE(data(row, AccessPointModel::SsidRole).toString(),
+                     QString("net%1").arg(9 - row));
+        }
+    }
+    void testStrengthHysteresis()
+    {
+        addAccessPoint("ap1", "home", "00:00:00:00:00:01", 50, 0);
+        QTRY_COMPARE(m_instance->rowCount(), 1);
+
+        QSignalSpy changedSpy(m_instance,
+            SIGNAL(dataChanged(QModelIndex, QModelIndex, QVector<int>)));
+
+        setStrength("ap1", 53);
+        QTest::qWait(700);
+        QCOMPARE(changedSpy.count(), 0);
+        QCOMPARE(data(0, AccessPointModel::StrengthRole).toUInt(), (uint) 50);
+
+        setStrength("ap1", 80);
+        QTRY_COMPARE(changedSpy.count(), 1);
+        QCOMPARE(data(0, AccessPointModel::StrengthRole).toUInt(), (uint) 80);
+    }
+    void testUpdatesWhileSortIsHeldBack()
+    {
+        addAccessPoint("ap1", "home", "00:00:00:00:00:01", 50, 0);
+        addAccessPoint("ap2", "cafe", "00:00:00:00:00:02", 30, 0);
+        QTRY_COMPARE(m_instance->rowCount(), 2);
+
+        // Leaves the rows out of order until the next sort is due.
+        setStrength("ap2", 80);
+        QTRY_VERIFY(data(0, AccessPointModel::StrengthRole).toUInt() == 80
+                    || data(1, AccessPointModel::StrengthRole).toUInt() == 80);
+
+        // Updates are not held back with the sort.
+        addAccessPoint("ap3", "library", "00:00:00:00:00:03", 10, 0);
+        QTRY_COMPARE_WITH_TIMEOUT(m_instance->rowCount(), 3, 1500);
+
+        QTRY_COMPARE(data(0, AccessPointModel::SsidRole).toString(), QString("cafe"));
+        QCOMPARE(data(1, AccessPointModel::SsidRole).toString(), QString("home"));
+        QCOMPARE(data(2, AccessPointModel::SsidRole).toString(), QString("library"));
+    }
+    void testSecuredFollowsChanges()
+    {
+        addAccessPoint("ap1", "home", "00:00:00:00:00:01", 50, 0);
+        QTRY_COMPARE(m_instance->rowCount(), 1);
+        QCOMPARE(data(0, AccessPointModel::SecuredRole).toBool(), false);
+
+        m_mock->call("SetProperty",
+                     "/org/freedesktop/NetworkManager/AccessPoint/ap1",
+                     "org.freedesktop.NetworkManager.AccessPoint",
+                     "RsnFlags",
+                     QVariant::fromValue(QDBusVariant(QVariant::fromValue(uint(0x100)))));
+        QTRY_COMPARE(data(0, AccessPointModel::SecuredRole).toBool(), true);
+    }
+    void testSharesWhatIsKnown()
+    {
+        addAccessPoint("ap1", "home", "00:00:00:00:00:01", 50, 0);
+        QTRY_COMPARE(m_instance->rowCount(), 1);
+
+        // Built on the same mirror and index, nothing is announced again.
+        AccessPointModel second(*m_dbus);
+        QTRY_COMPARE(second.rowCount(), 1);
+        QCOMPARE(second.data(second.index(0, 0), AccessPointModel::SsidRole).toString(),
+                 QString("home"));
+    }
+    void testRemove()
+    {
+        addAccessPoint("ap1", "home", "00:00:00:00:00:01", 50, 0);
+        addAccessPoint("ap2", "home", "00:00:00:00:00:02", 60, 0);
+        QTRY_COMPARE(m_instance->rowCount(), 1);
+
+        m_mock->call("RemoveAccessPoint", m_devPath,
+                     "/org/freedesktop/NetworkManager/AccessPoint/ap2");
+        QTRY_COMPARE(data(0, AccessPointModel::AccessPointPathRole).toString(),
+                     QString("/org/freedesktop/NetworkManager/AccessPoint/ap1"));
+
+        m_mock->call("RemoveAccessPoint", m_devPath,
+                     "/org/freedesktop/NetworkManager/AccessPoint/ap1");
+        QTRY_COMPARE(m_instance->rowCount(), 0);
+    }
+private:
+    void addAccessPoint(const QString &name, const QString &ssid,
+                        const QString &hwAddress, uchar strength,
+                        uint security)
+    {
+        auto args = QList<QVariant>();
+        args << m_devPath << name << ssid << hwAddress << (uint) 3
+             << (uint) 2437 << (uint) 54000 << QVariant::fromValue(strength)
+             << security;
+        m_mock->callWithArgumentList(QDBus::Block, "AddAccessPoint", args);
+    }
+    void setStrength(const QString &name, uchar strength)
+    {
+        m_mock->call("SetProperty",
+                     "/org/freedesktop/NetworkManager/AccessPoint/" + name,
+                     "org.freedesktop.NetworkManager.AccessPoint",
+                     "Strength",
+                     QVariant::fromValue(QDBusVariant(QVariant::fromValue(strength))));
+    }
+    QVariant data(int row, int role)
+    {
+        return m_instance->data(m_instance->index(row, 0), role);
+    }
+
+    FakeNetworkManager *m_nmMock;
+    QDBusInterface *m_mock;
+    AccessPointModel *m_instance;
+    QDBusConnection *m_dbus;
+    QString m_devPath;
+};
+
+QTEST_GUILESS_MAIN(TstAccessPointModel)
+#include "tst_accesspointmodel.moc"
@@ -0,0 +1,138 @@
+/*
+ * This file is part of system-settings
+ *
+ * Copyright (C) 2016 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3, as published
+ * by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranties of
+ * MERCHANTABILITY, SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "networkmanagermirror.h"
+#include "fakenetworkmanager.h"
+
+#include <QDBusMetaType>
+#include <QTest>
+#include <QSignalSpy>
+
+#define NM_DEVICE_IFACE "org.freedesktop.NetworkManager.Device"
+
+typedef QMap<QString,QVariantMap> ConfigurationData;
+Q_DECLARE_METATYPE(ConfigurationData)
+
+class TstNetworkManagerMirror: public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void init()
+    {
+        qDBusRegisterMetaType<ConfigurationData>();
+
+        QVariantMap parameters;
+        m_nmMock = new FakeNetworkManager(parameters);
+        m_dbus = new QDBusConnection(m_nmMock->dbus());
+        m_mock = new QDBusInterface(NM_SERVICE,
+                                    NM_MAIN_OBJECT,
+                                    "org.freedesktop.DBus.Mock",
+                                    *m_dbus);
+
+        QDBusReply<QString> reply = m_mock->call("AddWiFiDevice", "0", "wlan0", (uint) 100);
+        QVERIFY2(reply.isValid(), "Failed to create device");
+        m_devPath = reply.value();
+
+        auto ap = QList<QVariant>();
+        ap << m_devPath << "test_ap" << "test_ap" << "00:00:00:00:00:00" << (uint) 3
+           << (uint) 60 << (uint) 128 << QVariant::fromValue(uchar(0)) << (uint) 0x00000100;
+        QDBusReply<QString> apReply = m_mock->callWithArgumentList(QDBus::Block, "AddAccessPoint", ap);
+        QVERIFY2(apReply.isValid(), "Failed to create access point");
+        m_apPath = apReply.value();
+
+        m_mirror = new NetworkManagerMirror(*m_dbus);
+    }
+    void cleanup()
+    {
+        delete m_mirror;
+        delete m_mock;
+        delete m_dbus;
+        delete m_nmMock;
+    }
+    void testListsDevices()
+    {
+        QSignalSpy readySpy(m_mirror, SIGNAL(ready()));
+        QVERIFY(readySpy.wait());
+
+        QCOMPARE(m_mirror->devices(), QStringList() << m_devPath);
+        QCOMPARE(m_mirror->wifiDevice(), m_devPath);
+        QCOMPARE(m_mirror->device(m_devPath).type, (uint) 2);
+        QCOMPARE(m_mirror->device(m_devPath).ipInterface, QString("wlan0"));
+        QVERIFY(m_mirror->device(m_devPath).activeConnection.isEmpty());
+    }
+    void testShared()
+    {
+        QSharedPointer<NetworkManagerMirror> shared = NetworkManagerMirror::shared(*m_dbus);
+        QCOMPARE(NetworkManagerMirror::shared(*m_dbus).data(), shared.data());
+
+        QSignalSpy readySpy(shared.data(), SIGNAL(ready()));
+        QVERIFY(readySpy.wait());
+        QCOMPARE(shared->wifiDevice(), m_devPath);
+    }
+    void testFollowsAddedDevices()
+    {
+        QSignalSpy readySpy(m_mirror, SIGNAL(ready()));
+        QVERIFY(readySpy.wait());
+
+        QDBusReply<QString> reply = m_mock->call("AddEthernetDevice", "1", "eth0", (uint) 100);
+        QVERIFY(reply.isValid());
+
+        QTRY_COMPARE(m_mirror->devices(), QStringList() << m_devPath << reply.value());
+        QTRY_COMPARE(m_mirror->device(reply.value()).type, (uint) 1);
+        QCOMPARE(m_mirror->wifiDevice(), m_devPath);
+    }
+    void testFollowsActiveConnection()
+    {
+        QSignalSpy readySpy(m_mirror, SIGNAL(ready()));
+        QVERIFY(readySpy.wait());
+
+        QDBusReply<QString> connection = m_mock->call(
+            "AddWiFiConnection", m_devPath, "test_conn", "test_ap", "wpa-psk",
+            QVariant::fromValue(ConfigurationData()));
+        QVERIFY(connection.isValid());
+        QDBusReply<QString> active = m_mock->call(
+            "AddActiveConnection", QStringList() << m_devPath, connection.value(),
+            m_apPath, "test_active", (uint) 2);
+        QVERIFY(active.isValid());
+
+        // The template only sets the property; NetworkManager itself also
+        // announces it on the device interface.
+        QVariantMap changed;
+        changed.insert("ActiveConnection",
+                       QVariant::fromValue(QDBusObjectPath(active.value())));
+        QDBusInterface device(NM_SERVICE, m_devPath,
+                              "org.freedesktop.DBus.Mock", *m_dbus);
+        QDBusReply<void> emitted = device.call(
+            "EmitSignal", NM_DEVICE_IFACE, "PropertiesChanged", "a{sv}",
+            QVariantList() << QVariant(changed));
+        QVERIFY(emitted.isValid());
+
+        QTRY_COMPARE(m_mirror->device(m_devPath).activeConnection, active.value());
+        QTRY_COMPARE(m_mirror->connectionOf(active.value()), connection.value());
+    }
+private:
+    FakeNetworkManager *m_nmMock;
+    QDBusConnection *m_dbus;
+    QDBusInterface *m_mock;
+    NetworkManagerMirror *m_mirror;
+    QString m_devPath;
+    QString m_apPath;
+};
+
+QTEST_GUILESS_MAIN(TstNetworkManagerMirror)
+#include "tst_networkmanagermirror.moc"
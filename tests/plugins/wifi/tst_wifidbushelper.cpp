@@ -25,6 +25,9 @@
 #include <QTest>
 #include <QSignalSpy>
 
+typedef QMap<QString,QVariantMap> ConfigurationData;
+Q_DECLARE_METATYPE(ConfigurationData)
+
 class TstDbusHelper: public QObject
 {
     Q_OBJECT
@@ -127,9 +130,15 @@ private Q_SLOTS:
             m_mock, SIGNAL(MethodCalled(const QString &, const QVariantList &))
         );
 
+        QSignalSpy finishedSpy(
+            m_instance, SIGNAL(connectFinished(bool, const QString &))
+        );
+
         m_instance->connect(ssid, security, auth, usernames, password, certs, p2auth);
 
-        QVERIFY(m_methodSpy->wait());
+        QVERIFY(finishedSpy.wait());
+        QCOMPARE(finishedSpy.count(), 1);
+        QCOMPARE(finishedSpy.first().at(0).toBool(), true);
         QDBusReply<QList<MethodCall>> reply = m_mock->call("GetMethodCalls", "AddAndActivateConnection");
         QVERIFY2(reply.isValid(), "Method was not called correctly.");
         QCOMPARE(reply.value().size(), 1); // Called once.
@@ -150,7 +159,123 @@ private Q_SLOTS:
         auto state = qdbus_cast<uint>(state_v);
         QCOMPARE(state, (uint) 100);
     }
+    void testConnectToAddedAccessPoint()
+    {
+        QStringList usernames;
+        usernames << "user" << "" << "";
+        QStringList password;
+        password << "password" << "false";
+        QStringList certs;
+        certs << "" << "" << "" << "" << "" << "";
+
+        QSignalSpy finishedSpy(
+            m_instance, SIGNAL(connectFinished(bool, const QString &))
+        );
+
+        // The first connect builds the access point index.
+        m_instance->connect("test_ap_wpa", 1, 0, usernames, password, certs, 0);
+        QVERIFY(finishedSpy.wait());
+
+        // An access point appearing afterwards is picked up from signals.
+        auto late = QList<QVariant>();
+        late << m_devPath << "test_ap_late" << "test_ap_late" << "22:22:22:22:22:22" << (uint) 3
+             << (uint) 60 << (uint) 128 << QVariant::fromValue(uchar(0)) << (uint) 0x00000100;
+        m_mock->callWithArgumentList(QDBus::Block, "AddAccessPoint", late);
+        QTest::qWait(100);
+
+        m_instance->connect("test_ap_late", 1, 0, usernames, password, certs, 0);
+        QVERIFY(finishedSpy.wait());
+        QCOMPARE(finishedSpy.last().at(0).toBool(), true);
+
+        auto path_v = m_nmMock->getProperty(m_devPath,
+                                            "org.freedesktop.NetworkManager.Device",
+                                            "ActiveConnection");
+        auto path = qdbus_cast<QDBusObjectPath>(path_v).path();
+        QCOMPARE(path,
+                 QString("/org/freedesktop/NetworkManager/ActiveConnection/test_ap_late"));
+    }
+    void testForgetActivatedConnection()
+    {
+        QStringList usernames;
+        usernames << "user" << "" << "";
+        QStringList password;
+        password << "password" << "false";
+        QStringList certs;
+        certs << "" << "" << "" << "" << "" << "";
+
+        QSignalSpy finishedSpy(
+            m_instance, SIGNAL(connectFinished(bool, const QString &))
+        );
+        m_instance->connect("test_ap_wpa", 1, 0, usernames, password, certs, 0);
+        QVERIFY(finishedSpy.wait());
+        QCOMPARE(listConnections().size(), 1);
+
+        QVERIFY(m_instance->forgetActiveDevice());
+        QTRY_VERIFY(listConnections().isEmpty());
+    }
+    void testCancelBeforeConnectIsSent()
+    {
+        QString previous = activatePrevious();
+
+        QStringList usernames;
+        usernames << "user" << "" << "";
+        QStringList password;
+        password << "password" << "false";
+        QStringList certs;
+        certs << "" << "" << "" << "" << "" << "";
+
+        QSignalSpy finishedSpy(
+            m_instance, SIGNAL(connectFinished(bool, const QString &))
+        );
+
+        // Still queued: the mirror has not been filled yet.
+        m_instance->connect("test_ap_wpa", 1, 0, usernames, password, certs, 0);
+        QVERIFY(m_instance->forgetActiveDevice());
+        QCOMPARE(finishedSpy.count(), 1);
+        QCOMPARE(finishedSpy.first().at(0).toBool(), false);
+
+        QTest::qWait(500);
+        QDBusReply<QList<MethodCall>> reply = m_mock->call("GetMethodCalls", "AddAndActivateConnection");
+        QVERIFY(reply.isValid());
+        QCOMPARE(reply.value().size(), 0);
+
+        // The network the device was on before is kept.
+        QCOMPARE(listConnections(), QList<QDBusObjectPath>() << QDBusObjectPath(previous));
+    }
+    void testForgetAsksForActiveConnection()
+    {
+        activatePrevious();
+
+        // Nothing connected through the helper, and the mirror is not
+        // told about the new active connection by the template.
+        QVERIFY(m_instance->forgetActiveDevice());
+        QTRY_VERIFY(listConnections().isEmpty());
+    }
 private:
+    // A saved and active connection made by another client.
+    QString activatePrevious()
+    {
+        QDBusReply<QString> connection = m_mock->call(
+            "AddWiFiConnection", m_devPath, "test_previous", "test_ap_wpa",
+            "wpa-psk", QVariant::fromValue(ConfigurationData()));
+        if (!connection.isValid())
+            qWarning() << "Could not add connection:" << connection.error().message();
+        m_mock->call("AddActiveConnection", QStringList() << m_devPath,
+                     connection.value(),
+                     "/org/freedesktop/NetworkManager/AccessPoint/test_ap_wpa",
+                     "test_previous", (uint) 2);
+        return connection.value();
+    }
+    QList<QDBusObjectPath> listConnections()
+    {
+        QDBusInterface settings(NM_SERVICE,
+                                "/org/freedesktop/NetworkManager/Settings",
+                                "org.freedesktop.NetworkManager.Settings",
+                                *m_dbus);
+        QDBusReply<QList<QDBusObjectPath>> reply = settings.call("ListConnections");
+        return reply.value();
+    }
+
     QSignalSpy *m_methodSpy;
     FakeNetworkManager *m_nmMock;
     QDBusInterface *m_mock;